@@ -0,0 +1,99 @@
+//
+// Created by Mpho Mbotho on 2021-08-21.
+//
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cyntactic::bench {
+
+    /**
+     * Per run state handed to a benchmark. The benchmark body must call
+     * `run` exactly once with the code to be measured, and may report the
+     * number of bytes (or items) each iteration processes so the harness
+     * can print a throughput.
+     */
+    class State {
+    public:
+        explicit State(double minSeconds)
+            : mMinSeconds{minSeconds}
+        {}
+
+        void bytes(std::size_t n) { mBytes = n; }
+        void items(std::size_t n) { mItems = n; }
+        void counter(std::string name, double value) { mCounters.emplace_back(std::move(name), value); }
+
+        template <typename Func>
+        void run(Func&& func)
+        {
+            using Clock = std::chrono::steady_clock;
+            auto start = Clock::now();
+            do {
+                func();
+                mIterations++;
+                mElapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            } while (mElapsed < mMinSeconds);
+        }
+
+        std::size_t iterations() const { return mIterations; }
+        double seconds() const { return mElapsed / double(mIterations); }
+        std::size_t bytes() const { return mBytes; }
+        std::size_t items() const { return mItems; }
+        const std::vector<std::pair<std::string, double>>& counters() const { return mCounters; }
+
+    private:
+        double mMinSeconds{0.5};
+        double mElapsed{0};
+        std::size_t mIterations{0};
+        std::size_t mBytes{0};
+        std::size_t mItems{0};
+        std::vector<std::pair<std::string, double>> mCounters{};
+    };
+
+    struct Benchmark {
+        using Func = std::function<void(State&)>;
+        std::string_view Name;
+        Func Body;
+    };
+
+    std::vector<Benchmark>& registry();
+
+    struct Register {
+        Register(std::string_view name, Benchmark::Func func)
+        {
+            registry().push_back({name, std::move(func)});
+        }
+    };
+
+    /**
+     * Builds a source file of roughly \p size bytes by repeating \p unit,
+     * every copy of which must be a complete sequence of tokens
+     */
+    std::string repeat(std::string_view unit, std::size_t size);
+
+    /**
+     * @return the number of heap allocations made by the process so far
+     */
+    std::size_t allocations();
+
+    /**
+     * Hides \p value from the optimizer so that results are not discarded
+     */
+    template <typename T>
+    inline void keep(T&& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+}
+
+#define CYNT_BENCH_CAT_(a, b) a##b
+#define CYNT_BENCH_CAT(a, b) CYNT_BENCH_CAT_(a, b)
+#define CYNT_BENCH(name) \
+    static void CYNT_BENCH_CAT(bench_, __LINE__)(cyntactic::bench::State&); \
+    static cyntactic::bench::Register CYNT_BENCH_CAT(register_, __LINE__){name, CYNT_BENCH_CAT(bench_, __LINE__)}; \
+    static void CYNT_BENCH_CAT(bench_, __LINE__)(cyntactic::bench::State& state)
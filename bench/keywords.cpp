@@ -0,0 +1,80 @@
+//
+// Created by Mpho Mbotho on 2021-08-22.
+//
+
+#include "bench.hpp"
+#include "interner.hpp"
+#include "lexspec.hpp"
+
+#include <unordered_map>
+
+using cyntactic::Token;
+namespace bench = cyntactic::bench;
+namespace lex = cyntactic::lex;
+
+namespace {
+
+    /* Identifier heavy input, roughly one keyword for every four names */
+    const std::vector<std::string_view>& identifiers()
+    {
+        static const std::vector<std::string_view> Words = [] {
+            static const std::string_view Names[] = {
+                "counter", "i", "value", "return", "buffer_size", "x1", "int", "next_node",
+                "for", "index", "u64", "self", "parse_header", "while", "tmp", "structure",
+                "module_name", "if", "length", "importance", "result", "data", "func", "constant_42"
+            };
+            std::vector<std::string_view> words;
+            for (unsigned i = 0; i < (1u << 20); i++) {
+                words.push_back(Names[(i * 2654435761u >> 7) % std::size(Names)]);
+            }
+            return words;
+        }();
+        return Words;
+    }
+}
+
+CYNT_BENCH("keywords/unordered_map")
+{
+    std::unordered_map<std::string_view, Token::Kind> map;
+    for (const auto& kw: lex::Keywords) map.emplace(kw.Text, kw.Kind);
+    const auto& words = identifiers();
+    state.items(words.size());
+    state.run([&] {
+        unsigned keywords{0};
+        for (auto word: words) {
+            auto it = map.find(word);
+            keywords += (it != map.end());
+        }
+        bench::keep(keywords);
+    });
+}
+
+CYNT_BENCH("keywords/perfect_hash")
+{
+    const auto& words = identifiers();
+    state.items(words.size());
+    state.run([&] {
+        unsigned keywords{0};
+        for (auto word: words) {
+            keywords += (lex::keyword(word) != Token::IDENTIFIER);
+        }
+        bench::keep(keywords);
+    });
+}
+
+CYNT_BENCH("interner/suffixes")
+{
+    // generated names that only differ in their last bytes
+    std::vector<std::string> names;
+    for (unsigned i = 0; i < 54000; i++) {
+        names.push_back("var" + std::to_string(100000 + i).substr(1));
+    }
+    state.items(names.size());
+    state.run([&] {
+        cyntactic::Interner interner;
+        for (const auto& name: names) {
+            interner.intern(name);
+        }
+        bench::keep(interner.size());
+    });
+}
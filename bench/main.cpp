@@ -0,0 +1,104 @@
+//
+// Created by Mpho Mbotho on 2021-08-21.
+//
+
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+    std::atomic<std::size_t> gAllocations{0};
+}
+
+// counts every allocation of the process, benchmarks report it per iteration
+void* operator new(std::size_t size)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto *p = malloc(size? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    free(p);
+}
+
+namespace cyntactic::bench {
+
+    std::size_t allocations()
+    {
+        return gAllocations.load(std::memory_order_relaxed);
+    }
+
+    std::vector<Benchmark>& registry()
+    {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    std::string repeat(std::string_view unit, std::size_t size)
+    {
+        std::string out;
+        out.reserve(size + unit.size());
+        while (out.size() < size) out.append(unit);
+        return out;
+    }
+}
+
+/**
+ * Usage: cyntatic-bench [-t seconds] [filter...]
+ *
+ * Runs every registered benchmark whose name contains one of the given
+ * filters (or all of them if none is given).
+ */
+int main(int argc, char *argv[])
+{
+    using namespace cyntactic::bench;
+    double minSeconds{0.5};
+    std::vector<std::string_view> filters;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            minSeconds = atof(argv[++i]);
+        }
+        else {
+            filters.emplace_back(argv[i]);
+        }
+    }
+
+    auto selected = [&](std::string_view name) {
+        if (filters.empty()) return true;
+        for (auto& f: filters) {
+            if (name.find(f) != std::string_view::npos) return true;
+        }
+        return false;
+    };
+
+    for (const auto& b: registry()) {
+        if (!selected(b.Name)) continue;
+        State state{minSeconds};
+        b.Body(state);
+        printf("%-48.*s %12.3f us/iter", int(b.Name.size()), b.Name.data(), state.seconds() * 1e6);
+        if (state.bytes()) {
+            printf(" %10.1f MB/s", double(state.bytes()) / state.seconds() / 1e6);
+        }
+        if (state.items()) {
+            printf(" %10.2f M items/s", double(state.items()) / state.seconds() / 1e6);
+        }
+        for (const auto& [name, value]: state.counters()) {
+            printf(" %s=%g", name.c_str(), value);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "bench.hpp"
+#include "numbers.hpp"
+#include "parser.hpp"
+
+#include <cstdio>
+#include <string>
+
+using cyntactic::Parser;
+namespace bench = cyntactic::bench;
+namespace num = cyntactic::num;
+
+namespace {
+
+    /* A generated constant table, one literal per entry in every base */
+    const std::string& table()
+    {
+        static const std::string Table = [] {
+            std::string code;
+            for (std::uint64_t i = 0; i < 100'000; i++) {
+                auto v = i * 2654435761u;
+                switch (i % 4) {
+                    case 0: code += std::to_string(v); break;
+                    case 1: code += "0x" + std::to_string(v % 1000) + "ABCDEF"; break;
+                    case 2: {
+                        char octal[24];
+                        snprintf(octal, sizeof(octal), "0%llo", (unsigned long long) (v % 4096));
+                        code += octal;
+                        break;
+                    }
+                    default: code += std::to_string(v % 1000) + "." + std::to_string(i) + "e-3"; break;
+                }
+                code += (i % 8 == 7)? ";\n" : " + ";
+            }
+            return code + "0;\n";
+        }();
+        return Table;
+    }
+
+    struct Literal {
+        std::string_view Text;
+        int Base;
+    };
+
+    const std::vector<Literal>& integers()
+    {
+        static const std::vector<Literal> Literals = [] {
+            std::vector<Literal> literals;
+            cyntactic::Tokenizer tokenizer{table()};
+            auto tokens = tokenizer.tokenizeAll();
+            for (std::size_t i = 0; i < tokens.size(); i++) {
+                switch (tokens.kind(i)) {
+                    case cyntactic::Token::DEC_LITERAL: literals.push_back({tokens.value(i), 10}); break;
+                    case cyntactic::Token::HEX_LITERAL: literals.push_back({tokens.value(i), 16}); break;
+                    case cyntactic::Token::OCT_LITERAL: literals.push_back({tokens.value(i), 8}); break;
+                    default: break;
+                }
+            }
+            return literals;
+        }();
+        return Literals;
+    }
+}
+
+CYNT_BENCH("numbers/stoull")
+{
+    const auto& literals = integers();
+    state.items(literals.size());
+    state.run([&] {
+        std::uint64_t sum{0};
+        for (const auto& lit: literals) {
+            sum += std::stoull(std::string{lit.Text}, nullptr, lit.Base);
+        }
+        bench::keep(sum);
+    });
+}
+
+CYNT_BENCH("numbers/from_chars")
+{
+    const auto& literals = integers();
+    state.items(literals.size());
+    state.run([&] {
+        std::uint64_t sum{0};
+        for (const auto& lit: literals) {
+            std::uint64_t value{0};
+            num::integer(lit.Text, lit.Base, value);
+            sum += value;
+        }
+        bench::keep(sum);
+    });
+}
+
+CYNT_BENCH("parser/literals")
+{
+    const auto& code = table();
+    state.bytes(code.size());
+    state.items(100'000);
+    state.run([&] {
+        Parser parser;
+        bench::keep(parser.parse(code, "<bench>"));
+    });
+}
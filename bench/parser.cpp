@@ -0,0 +1,226 @@
+//
+// Created by Mpho Mbotho on 2021-08-23.
+//
+
+#include "bench.hpp"
+#include "flatast.hpp"
+#include "parser.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+using cyntactic::Parser;
+namespace bench = cyntactic::bench;
+
+namespace {
+
+    const std::string& expressions()
+    {
+        static const std::string Source = bench::repeat(
+            "1 + 2 * 3 - 4 / 5 == 0x10 * 0b11 - 017;\n"
+            "'a' + 'b' > 'c';   // a comment to skip\n", 2 << 20);
+        return Source;
+    }
+
+    std::size_t count(const cyntactic::Node& root)
+    {
+        std::size_t n{0};
+        std::vector<const cyntactic::Node*> pending{&root};
+        while (!pending.empty()) {
+            auto node = pending.back();
+            pending.pop_back();
+            n++;
+            pending.insert(pending.end(), node->Children.begin(), node->Children.end());
+        }
+        return n;
+    }
+}
+
+CYNT_BENCH("parser/expressions")
+{
+    const auto& source = expressions();
+    state.bytes(source.size());
+    state.counter("expressions", double(std::count(source.begin(), source.end(), ';')));
+    state.run([&] {
+        Parser parser;
+        bench::keep(parser.parse(source, "<bench>"));
+    });
+}
+
+CYNT_BENCH("parser/expressions/pipelined")
+{
+    // lexing overlaps parsing, only faster than the above with a core to spare
+    const auto& source = expressions();
+    state.bytes(source.size());
+    state.run([&] {
+        Parser parser;
+        parser.pipelined(true);
+        bench::keep(parser.parse(source, "<bench>"));
+    });
+}
+
+CYNT_BENCH("parser/deep")
+{
+    // a single expression of a million terms, as deep as the tree gets
+    static const std::string Source = [] {
+        std::string code{"1"};
+        for (std::size_t i = 1; i < 1000000; i++) code += " + 1";
+        return code + ";\n";
+    }();
+    state.bytes(Source.size());
+    std::size_t nodes{0};
+    state.run([&] {
+        Parser parser;
+        auto pg = parser.parse(Source, "<bench>");
+        nodes = count(pg);
+        bench::keep(pg);
+    });
+    state.counter("nodes", double(nodes));
+}
+
+CYNT_BENCH("parser/errors")
+{
+    // every line broken, the time per error is what reporting and resuming cost
+    static const std::string Source = bench::repeat(
+        "1 + 2 * 3 - 4 / 5 == 0x10 * 0b11 017;\n"
+        "'a' + 'b' > ;   // a comment to skip\n", 2 << 20);
+    state.bytes(Source.size());
+    std::size_t errors{0};
+    auto before = bench::allocations();
+    state.run([&] {
+        Parser parser;
+        parser.recover(true);
+        bench::keep(parser.parse(Source, "<bench>"));
+        errors = parser.diagnostics().size();
+    });
+    state.counter("errors", double(errors));
+    state.counter("allocs/error", double(bench::allocations() - before) / double(state.iterations() * errors));
+}
+
+CYNT_BENCH("parser/imports")
+{
+    static const std::string Source = bench::repeat(
+        "import collections.{vector, map, set, queue} -> containers;\n"
+        "import system.io -> io;\n", 2 << 20);
+    state.bytes(Source.size());
+    state.run([&] {
+        Parser parser;
+        bench::keep(parser.parse(Source, "<bench>"));
+    });
+}
+
+namespace {
+
+    const std::string& module()
+    {
+        // declarations up front, most of the bytes in bodies
+        static const std::string Source = bench::repeat(
+            "import collections.{vector, map} -> containers;\n"
+            "{\n"
+            "    1 + 2 * 3 - 4 / 5 == 0x10 * 0b11 - 017;\n"
+            "    'a' + 'b' > 'c';   // a comment with a } to skip\n"
+            "    { \"nested {\" + \"string\" <= 1.5e3; 42 << 3; }\n"
+            "    1 + 2 * 3 - 4 / 5 == 0x10 * 0b11 - 017;\n"
+            "}\n", 2 << 20);
+        return Source;
+    }
+}
+
+CYNT_BENCH("parser/bodies")
+{
+    const auto& source = module();
+    state.bytes(source.size());
+    state.run([&] {
+        Parser parser;
+        bench::keep(parser.parse(source, "<bench>"));
+    });
+}
+
+CYNT_BENCH("parser/bodies/lazy")
+{
+    // only the imports are parsed, bodies are skipped by a brace scan
+    const auto& source = module();
+    state.bytes(source.size());
+    state.run([&] {
+        Parser parser;
+        parser.lazy(true);
+        bench::keep(parser.parse(source, "<bench>"));
+    });
+}
+
+CYNT_BENCH("parser/strings")
+{
+    // the string tables of generated sources, one literal in four has escapes
+    static const std::string Source = bench::repeat(
+        "\"generated_string_table_entry_one\" + \"generated_string_table_entry_two\";\n"
+        "\"generated_string_table_entry_three\" + \"entry with \\\"escapes\\\"\\n\";\n", 2 << 20);
+    auto literals = std::count(Source.begin(), Source.end(), '\n') * 2;
+    state.bytes(Source.size());
+    auto before = bench::allocations();
+    state.run([&] {
+        Parser parser;
+        bench::keep(parser.parse(Source, "<bench>"));
+    });
+    state.counter("allocs/literal", double(bench::allocations() - before) / double(state.iterations() * literals));
+}
+
+CYNT_BENCH("parser/ast")
+{
+    // parsing and tearing down the tree, the latter is also reported on its own
+    using Clock = std::chrono::steady_clock;
+    const auto& source = expressions();
+    state.bytes(source.size());
+    std::size_t nodes{0};
+    double teardown{0};
+    auto before = bench::allocations();
+    state.run([&] {
+        Parser parser;
+        std::optional<cyntactic::Program> pg{parser.parse(source, "<bench>")};
+        nodes = count(*pg);
+        auto start = Clock::now();
+        pg.reset();
+        teardown += std::chrono::duration<double>(Clock::now() - start).count();
+    });
+    state.counter("allocs/node", double(bench::allocations() - before) / double(state.iterations() * nodes));
+    state.counter("teardown ms", teardown * 1000 / double(state.iterations()));
+}
+
+CYNT_BENCH("ast/walk/tree")
+{
+    // visits every node of a 2 MB program, looking for literals
+    static const auto Pg = Parser{}.parse(expressions(), "<bench>");
+    auto literals = [](const cyntactic::Node& root) {
+        std::size_t n{0};
+        std::vector<const cyntactic::Node*> stack{&root};
+        while (!stack.empty()) {
+            const auto *node = stack.back();
+            stack.pop_back();
+            n += node->Tag == cyntactic::Node::LITERAL;
+            stack.insert(stack.end(), node->Children.begin(), node->Children.end());
+        }
+        return n;
+    };
+    state.items(count(Pg));
+    state.run([&] {
+        bench::keep(literals(Pg));
+    });
+}
+
+CYNT_BENCH("ast/walk/flat")
+{
+    static const auto Flat = cyntactic::FlatAst::flatten(Parser{}.parse(expressions(), "<bench>"));
+    state.items(Flat.size());
+    state.run([&] {
+        bench::keep(std::count(Flat.Tags.begin(), Flat.Tags.end(), cyntactic::Node::LITERAL));
+    });
+}
+
+CYNT_BENCH("ast/flatten")
+{
+    static const auto Pg = Parser{}.parse(expressions(), "<bench>");
+    state.items(count(Pg));
+    state.run([&] {
+        bench::keep(cyntactic::FlatAst::flatten(Pg));
+    });
+}
@@ -0,0 +1,331 @@
+//
+// Created by Mpho Mbotho on 2021-08-21.
+//
+
+#include "bench.hpp"
+#include "exceptions.hpp"
+#include "scanner.hpp"
+#include "tokenizer.hpp"
+
+#include <cstdlib>
+
+using cyntactic::Token;
+using cyntactic::Tokenizer;
+namespace bench = cyntactic::bench;
+namespace scan = cyntactic::scan;
+
+namespace {
+
+    constexpr std::size_t SourceSize = 8 << 20;
+
+    /* Mirrors generated sources: license headers, deep indentation and long names */
+    const std::string& generatedSource()
+    {
+        static const std::string Source = bench::repeat(
+R"(/*
+ * Copyright (c) 2021 Cyntactic Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy
+ * of the License at http://www.apache.org/licenses/LICENSE-2.0
+ */
+import generated_module_with_a_long_name.{first_generated_symbol, second_generated_symbol};
+                                // generated by the schema compiler, do not edit
+                                this_is_a_generated_identifier_of_some_length + another_generated_identifier_name;
+                                the_generated_value_for_constant_number_one * the_generated_value_for_constant_number_two;
+)", SourceSize);
+        return Source;
+    }
+
+    std::size_t lex(std::string_view code)
+    {
+        Tokenizer tokenizer{code};
+        std::size_t count{0};
+        while (tokenizer.next().kind != Token::T_EOF) count++;
+        return count;
+    }
+
+    void lexWith(bench::State& state, scan::Isa isa)
+    {
+        auto previous = scan::isa();
+        scan::select(isa);
+        const auto& code = generatedSource();
+        state.bytes(code.size());
+        state.run([&] { bench::keep(lex(code)); });
+        scan::select(previous);
+    }
+}
+
+CYNT_BENCH("tokenizer/generated/scalar")
+{
+    lexWith(state, scan::SCALAR);
+}
+
+CYNT_BENCH("tokenizer/generated/sse2")
+{
+    lexWith(state, scan::SSE2);
+}
+
+CYNT_BENCH("tokenizer/generated/avx2")
+{
+    lexWith(state, scan::AVX2);
+}
+
+namespace {
+
+    /* Mostly ASCII code with non-ASCII names, strings and comments on every line */
+    const std::string& utf8Source()
+    {
+        static const std::string Source = bench::repeat(
+            "gr\xC3\xB6\xC3\x9F""e = caf\xC3\xA9 + \"str\xC3\xB6m \xE2\x82\xAC\";"
+            "   // \xE4\xB8\xAD\xE6\x96\x87 comment \xF0\x9F\x98\x80\n"
+            "                                this_is_a_generated_identifier_of_some_length + another_one;\n",
+            SourceSize);
+        return Source;
+    }
+
+    void validateWith(bench::State& state, scan::Isa isa)
+    {
+        auto previous = scan::isa();
+        scan::select(isa);
+        const auto& code = utf8Source();
+        state.bytes(code.size());
+        state.run([&] { bench::keep(scan::utf8(code.data(), code.data() + code.size())); });
+        scan::select(previous);
+    }
+}
+
+CYNT_BENCH("scan/utf8/scalar")
+{
+    validateWith(state, scan::SCALAR);
+}
+
+CYNT_BENCH("scan/utf8/sse2")
+{
+    validateWith(state, scan::SSE2);
+}
+
+CYNT_BENCH("scan/utf8/avx2")
+{
+    validateWith(state, scan::AVX2);
+}
+
+CYNT_BENCH("tokenizer/utf8")
+{
+    const auto& code = utf8Source();
+    state.bytes(code.size());
+    state.run([&] { bench::keep(lex(code)); });
+}
+
+namespace {
+
+    /* Machine generated garbage, one lexical error on every line */
+    const std::string& brokenSource()
+    {
+        static const std::string Source = bench::repeat(
+            "value_one = value_two # 0x10;\nconst_three = 'ab' + 1e;\n", 1 << 20);
+        return Source;
+    }
+}
+
+CYNT_BENCH("tokenizer/errors/throwing")
+{
+    const auto& code = brokenSource();
+    state.bytes(code.size());
+    state.run([&] {
+        Tokenizer tokenizer{code};
+        std::size_t errors{0};
+        while (true) {
+            try {
+                if (tokenizer.next().kind == Token::T_EOF) break;
+            }
+            catch (const cyntactic::SyntaxError&) {
+                errors++;
+            }
+        }
+        bench::keep(errors);
+    });
+}
+
+CYNT_BENCH("tokenizer/errors/recovering")
+{
+    const auto& code = brokenSource();
+    state.bytes(code.size());
+    state.run([&] {
+        Tokenizer tokenizer{code};
+        tokenizer.recover(true);
+        std::size_t errors{0};
+        Token tok;
+        while ((tok = tokenizer.next()).kind != Token::T_EOF) {
+            errors += tok.kind == Token::ERROR;
+        }
+        bench::keep(errors);
+    });
+}
+
+CYNT_BENCH("tokenizer/operators")
+{
+    static const std::string Source = bench::repeat(
+        "+= <<= >> -> :: ... != && || <= >= % ^ | & * / - == ( ) [ ] { } ;\n", SourceSize);
+    state.bytes(Source.size());
+    state.run([&] { bench::keep(lex(Source)); });
+}
+
+CYNT_BENCH("tokenizer/tokenizeAll")
+{
+    const auto& code = generatedSource();
+    std::size_t tokens{0};
+    state.bytes(code.size());
+    state.run([&] {
+        auto buffer = Tokenizer{code}.tokenizeAll();
+        tokens = buffer.size();
+        bench::keep(buffer);
+    });
+    state.items(tokens);
+    state.counter("bytes/token", double(sizeof(std::uint8_t) + 2 * sizeof(std::uint32_t)));
+}
+
+namespace {
+
+    /* Size of the parallel lexing corpus, CYNT_BENCH_MB=500 reproduces the 500MB case */
+    const std::string& largeSource()
+    {
+        static const std::string Source = [] {
+            const char *mb = getenv("CYNT_BENCH_MB");
+            return bench::repeat(generatedSource().substr(0, 1 << 20),
+                                 std::size_t(mb? atoi(mb) : 64) << 20);
+        }();
+        return Source;
+    }
+
+    void lexParallel(bench::State& state, unsigned threads)
+    {
+        const auto& code = largeSource();
+        state.bytes(code.size());
+        state.run([&] { bench::keep(Tokenizer{code}.tokenizeAll(threads)); });
+    }
+}
+
+CYNT_BENCH("tokenizer/parallel/1")
+{
+    lexParallel(state, 1);
+}
+
+CYNT_BENCH("tokenizer/parallel/2")
+{
+    lexParallel(state, 2);
+}
+
+CYNT_BENCH("tokenizer/parallel/4")
+{
+    lexParallel(state, 4);
+}
+
+CYNT_BENCH("tokenizer/parallel/8")
+{
+    lexParallel(state, 8);
+}
+
+CYNT_BENCH("tokenizer/parallel/16")
+{
+    lexParallel(state, 16);
+}
+
+namespace {
+
+    /* An editor buffer of 50k lines */
+    std::string editorSource()
+    {
+        std::string code;
+        for (unsigned line = 0; line < 50'000; line++) {
+            switch (line % 5) {
+                case 0: code += "import module_" + std::to_string(line) + ".{first, second} -> alias;\n"; break;
+                case 1: code += "    counter_value += 0x1F * next_value - 1.5e3; // update\n"; break;
+                case 2: code += "    message = \"a string literal\" + 'c';\n"; break;
+                case 3: code += "    /* a block comment */ result = left << 2 >= right;\n"; break;
+                default: code += "\n"; break;
+            }
+        }
+        return code;
+    }
+
+    /* Types a character at a cursor that slowly walks through the file, then deletes it */
+    void relex(bench::State& state, Tokenizer::TriviaMode mode, std::size_t stride)
+    {
+        auto code = editorSource();
+        Tokenizer tokenizer{code};
+        // typing inside a literal breaks it for a moment
+        tokenizer.recover(true);
+        tokenizer.trivia(mode);
+        auto tokens = tokenizer.tokenizeAll();
+        std::size_t cursor{code.size() / 2}, relexed{0}, edits{0};
+        state.items(2);
+        state.run([&] {
+            cursor = (cursor + stride) % code.size();
+            code.insert(cursor, 1, 'x');
+            auto [first, last] = tokenizer.relex(tokens, code, {cursor, 0, "x"});
+            relexed += last - first;
+            code.erase(cursor, 1);
+            std::tie(first, last) = tokenizer.relex(tokens, code, {cursor, 1, ""});
+            relexed += last - first;
+            edits += 2;
+        });
+        state.counter("tokens relexed/edit", double(relexed) / double(edits));
+    }
+}
+
+CYNT_BENCH("relex/full")
+{
+    auto code = editorSource();
+    state.bytes(code.size());
+    state.run([&] { bench::keep(Tokenizer{code}.tokenizeAll()); });
+}
+
+CYNT_BENCH("relex/typing")
+{
+    relex(state, Tokenizer::TRIVIA_TOKENS, 1);
+}
+
+CYNT_BENCH("relex/jumping")
+{
+    relex(state, Tokenizer::TRIVIA_TOKENS, 7919 * 13);
+}
+
+CYNT_BENCH("relex/typing/collect")
+{
+    relex(state, Tokenizer::TRIVIA_COLLECT, 1);
+}
+
+namespace {
+
+    /* Short tokens, where per byte bounds checks weigh the most */
+    const std::string& denseSource()
+    {
+        static const std::string Source = bench::repeat(
+            "x1 = 0x1F + 017 * 1.5e3 - 'c' / \"str\" >= 0b101 << 2 && y != 42; // c\n", SourceSize);
+        return Source;
+    }
+
+    template <typename... Args>
+    void lexNext(bench::State& state, Args&&... args)
+    {
+        state.bytes(denseSource().size());
+        state.run([&] {
+            Tokenizer tokenizer{std::forward<Args>(args)...};
+            std::size_t count{0};
+            while (tokenizer.next().kind != Token::T_EOF) count++;
+            bench::keep(count);
+        });
+    }
+}
+
+CYNT_BENCH("tokenizer/next/checked")
+{
+    lexNext(state, std::string_view{denseSource()});
+}
+
+CYNT_BENCH("tokenizer/next/padded")
+{
+    auto source = cyntactic::SourceBuffer::copy(denseSource(), "<bench>");
+    lexNext(state, *source);
+}
@@ -0,0 +1,61 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace cyntactic {
+
+    /**
+     * Bump allocator for data that lives as long as a compilation, such as
+     * interned names and decoded literals. Memory is carved out of large
+     * blocks, nothing is freed or moved before the arena itself goes away.
+     */
+    class Arena {
+    public:
+        using Ptr = std::shared_ptr<Arena>;
+        static constexpr std::size_t BlockSize{64 * 1024};
+
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /**
+         * @return \p size bytes aligned to \p align, which must be a power of 2
+         */
+        void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t))
+        {
+            auto pad = std::size_t(-reinterpret_cast<std::uintptr_t>(mCursor)) & (align - 1);
+            if (size + pad > mAvailable) {
+                return grow(size, align);
+            }
+            auto *p = mCursor + pad;
+            mCursor = p + size;
+            mAvailable -= size + pad;
+            return p;
+        }
+
+        /**
+         * @return a copy of \p text owned by the arena
+         */
+        std::string_view copy(std::string_view text);
+
+        /**
+         * @return the number of blocks requested from the system so far
+         */
+        std::size_t blocks() const { return mBlocks.size(); }
+
+    private:
+        void* grow(std::size_t size, std::size_t align);
+
+        std::vector<std::unique_ptr<char[]>> mBlocks{};
+        char *mCursor{nullptr};
+        std::size_t mAvailable{0};
+    };
+}
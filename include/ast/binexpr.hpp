@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <array>
+#include <string_view>
+
 #include <node.hpp>
 #include <tokenizer.hpp>
 
@@ -22,29 +25,150 @@ namespace cyntactic::ast {
         OP_EQ,
         OP_LT,
         OP_GT,
+        OP_SHL,
+        OP_SHR,
+        OP_BIT_AND,
+        OP_BIT_OR,
+        OP_BIT_XOR,
+        OP_AND,
+        OP_OR,
+        OP_ASSIGN,
+        OP_ADD_ASSIGN,
+        OP_SUB_ASSIGN,
+        OP_MUL_ASSIGN,
+        OP_DIV_ASSIGN,
+        OP_MOD_ASSIGN,
+        OP_SHL_ASSIGN,
+        OP_SHR_ASSIGN,
+        OP_AND_ASSIGN,
+        OP_OR_ASSIGN,
+        OP_XOR_ASSIGN,
     };
 
     struct BinaryOpInfo {
+        typedef enum {
+            LEFT,
+            RIGHT
+        } Associativity;
+
         BinaryOp Op{BinaryOp::OP_NONE};
         std::string_view Str{};
         unsigned Precedence{0};
-        operator bool() const { return Op != BinaryOp::OP_NONE; }
-        static BinaryOpInfo find(Token::Kind token);
+        Associativity Assoc{LEFT};
+        constexpr operator bool() const { return Op != BinaryOp::OP_NONE; }
+
+        /**
+         * @return the operator spelled by \p token, a falsy one if it is not
+         * a binary operator
+         */
+        static constexpr const BinaryOpInfo& find(Token::Kind token);
+
+        /**
+         * @return the info of \p op
+         */
+        static constexpr const BinaryOpInfo& of(BinaryOp op);
+    };
+
+    struct BinaryOperator {
+        Token::Kind  Kind;
+        BinaryOpInfo Info;
     };
 
+    /**
+     * Every binary operator with its precedence (higher binds tighter) and
+     * associativity, following C. The lookup tables used by the parser are
+     * generated from this list at compile time.
+     */
+    inline constexpr BinaryOperator BinaryOperators[] = {
+        {Token::EQUALS,       {BinaryOp::OP_ASSIGN,     "=",   1, BinaryOpInfo::RIGHT}},
+        {Token::OP_PLUS_EQ,   {BinaryOp::OP_ADD_ASSIGN, "+=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_MINUS_EQ,  {BinaryOp::OP_SUB_ASSIGN, "-=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_MULT_EQ,   {BinaryOp::OP_MUL_ASSIGN, "*=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_DIV_EQ,    {BinaryOp::OP_DIV_ASSIGN, "/=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_MOD_EQ,    {BinaryOp::OP_MOD_ASSIGN, "%=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_LSHIFT_EQ, {BinaryOp::OP_SHL_ASSIGN, "<<=", 1, BinaryOpInfo::RIGHT}},
+        {Token::OP_RSHIFT_EQ, {BinaryOp::OP_SHR_ASSIGN, ">>=", 1, BinaryOpInfo::RIGHT}},
+        {Token::OP_AND_EQ,    {BinaryOp::OP_AND_ASSIGN, "&=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_OR_EQ,     {BinaryOp::OP_OR_ASSIGN,  "|=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_XOR_EQ,    {BinaryOp::OP_XOR_ASSIGN, "^=",  1, BinaryOpInfo::RIGHT}},
+        {Token::OP_LOR,       {BinaryOp::OP_OR,         "||",  2}},
+        {Token::OP_LAND,      {BinaryOp::OP_AND,        "&&",  3}},
+        {Token::BAR,          {BinaryOp::OP_BIT_OR,     "|",   4}},
+        {Token::CARET,        {BinaryOp::OP_BIT_XOR,    "^",   5}},
+        {Token::AMPERSAND,    {BinaryOp::OP_BIT_AND,    "&",   6}},
+        {Token::OP_EQ,        {BinaryOp::OP_EQ,         "==",  7}},
+        {Token::OP_NEQ,       {BinaryOp::OP_NEQ,        "!=",  7}},
+        {Token::LESS_THAN,    {BinaryOp::OP_LT,         "<",   8}},
+        {Token::GREATER_THAN, {BinaryOp::OP_GT,         ">",   8}},
+        {Token::OP_LTE,       {BinaryOp::OP_LEQ,        "<=",  8}},
+        {Token::OP_GTE,       {BinaryOp::OP_GEQ,        ">=",  8}},
+        {Token::OP_LSHIFT,    {BinaryOp::OP_SHL,        "<<",  9}},
+        {Token::OP_RSHIFT,    {BinaryOp::OP_SHR,        ">>",  9}},
+        {Token::PLUS,         {BinaryOp::OP_ADD,        "+",  10}},
+        {Token::MINUS,        {BinaryOp::OP_SUB,        "-",  10}},
+        {Token::STAR,         {BinaryOp::OP_MUL,        "*",  11}},
+        {Token::SLASH,        {BinaryOp::OP_DIV,        "/",  11}},
+        {Token::PERCENT,      {BinaryOp::OP_MOD,        "%",  11}},
+    };
+
+    namespace detail {
+
+        struct OperatorTables {
+            std::array<BinaryOpInfo, Token::ERROR + 1> ByToken{};
+            std::array<BinaryOpInfo, std::size(BinaryOperators) + 1> ByOp{};
+        };
+
+        constexpr OperatorTables buildOperatorTables()
+        {
+            OperatorTables t{};
+            for (const auto& op: BinaryOperators) {
+                t.ByToken[op.Kind] = op.Info;
+                t.ByOp[std::size_t(op.Info.Op)] = op.Info;
+            }
+            return t;
+        }
+
+        constexpr bool operatorsComplete(const OperatorTables& t)
+        {
+            // every BinaryOp but OP_NONE is in the list exactly once
+            for (std::size_t op = 1; op < t.ByOp.size(); op++) {
+                if (std::size_t(t.ByOp[op].Op) != op) return false;
+            }
+            return true;
+        }
+    }
+
+    inline constexpr detail::OperatorTables OperatorTable = detail::buildOperatorTables();
+
+    static_assert(detail::operatorsComplete(OperatorTable), "BinaryOperators must list every BinaryOp once");
+
+    constexpr const BinaryOpInfo& BinaryOpInfo::find(Token::Kind token)
+    {
+        return OperatorTable.ByToken[token];
+    }
+
+    constexpr const BinaryOpInfo& BinaryOpInfo::of(BinaryOp op)
+    {
+        return OperatorTable.ByOp[std::size_t(op)];
+    }
+
+    static_assert(BinaryOpInfo::find(Token::STAR).Precedence > BinaryOpInfo::find(Token::PLUS).Precedence);
+    static_assert(!BinaryOpInfo::find(Token::SEMICOLON) && !BinaryOpInfo::find(Token::T_EOF));
+
     class BinaryExpr : public Node {
     public:
         BinaryExpr() : Node(Node::BINARY_EXPR) {}
-        BinaryExpr(BinaryOpInfo op, Node::Ptr&& left, Node::Ptr&& right)
+        BinaryExpr(BinaryOpInfo op, Node::Ptr left, Node::Ptr right)
             : Node(Node::BINARY_EXPR),
               Op{op}
         {
-            Children.push_back(std::move(left));
-            Children.push_back(std::move(right));
+            // both fit in the inline slots
+            Children.push_back(left);
+            Children.push_back(right);
         }
         BinaryOpInfo Op{};
 
     protected:
-        std::string toString(bool compressed = true) const override;
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
     };
 }
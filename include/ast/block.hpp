@@ -0,0 +1,62 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <arena.hpp>
+#include <diagnostics.hpp>
+#include <interner.hpp>
+#include <node.hpp>
+#include <source.hpp>
+
+namespace cyntactic::ast {
+
+    /**
+     * Statements between braces. A lazy parse skips the body of a block
+     * and only records where it is, the body is parsed the first time
+     * body() is called.
+     */
+    class Block : public Node {
+    public:
+        /**
+         * What the skipped blocks of a program need to parse their body,
+         * shared by all of them and kept in the program's AST arena
+         */
+        struct Context {
+            SourceBuffer::Ptr Buffer{};
+            SourceManager::Ptr Sources{};
+            Interner::Ptr Names{};
+            Arena::Ptr Strings{};
+            // the arena holds the context
+            std::weak_ptr<AstArena> Nodes{};
+            SourceLoc Base{};
+            // the program's, where problems found in the bodies are reported
+            std::shared_ptr<DiagnosticEngine> Diagnostics{};
+            bool Recover{false};
+        };
+
+        Block() : Node(Node::BLOCK) {}
+
+        bool lazy() const { return Source != nullptr; }
+
+        /**
+         * @return the statements of the block, parsing them first if the
+         * block was skipped. Syntax errors in the body are thrown from here
+         * unless the program was parsed with recovery on, every other
+         * problem is reported into the program's Diagnostics.
+         */
+        const NodeList& body() const;
+
+        // set until the body of a skipped block is parsed
+        Context *Source{nullptr};
+        // the code between the braces of a skipped block
+        std::uint32_t Offset{0};
+        std::uint32_t Size{0};
+    protected:
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
+    };
+}
@@ -0,0 +1,27 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <string_view>
+
+#include <node.hpp>
+
+namespace cyntactic::ast {
+
+    /**
+     * Stands in for a statement that failed to parse, Code is the text
+     * skipped to get back in sync
+     */
+    class Error : public Node {
+    public:
+        Error() : Node(Node::ERROR) {}
+        Error(std::string_view code)
+            : Node(Node::ERROR), Code{code}
+        {}
+        std::string_view Code{};
+    protected:
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
+    };
+}
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <interner.hpp>
 #include <node.hpp>
 
 namespace cyntactic::ast {
@@ -11,11 +12,11 @@ namespace cyntactic::ast {
     class Identifier : public Node {
     public:
         Identifier() : Node(Node::IDENT) {}
-        Identifier(const std::string_view& name)
+        Identifier(Interner::Id name)
             : Node(Node::IDENT), Name{name}
         {}
-        std::string Name{};
+        Interner::Id Name{Interner::None};
     protected:
-        std::string toString(bool compressed = true) const override;
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
     };
 }
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <span>
+
+#include <interner.hpp>
 #include <node.hpp>
 
 namespace cyntactic {
@@ -15,11 +18,14 @@ namespace cyntactic::ast {
     class Import : public Node {
     public:
         Import() : Node(Node::IMPORT){}
-        std::string Name{};
-        std::string Alias{};
-        std::vector<std::string> Symbols{};
+        Interner::Id Name{Interner::None};
+        Interner::Id Alias{Interner::None};
+        std::vector<Interner::Id> Symbols{};
+
+        static std::string str(const Interner *names, Interner::Id name, std::span<const Interner::Id> symbols,
+                               Interner::Id alias, bool compressed);
 
     protected:
-        std::string toString(bool compressed = true) const override;
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
     };
 }
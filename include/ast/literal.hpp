@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <string_view>
 #include <variant>
 
 #include <node.hpp>
@@ -27,7 +28,8 @@ namespace cyntactic::ast {
         Literal(T&& value) : Node(Node::LITERAL), mValue{std::forward<T>(value)}
         {}
 
-        using Variant = std::variant<std::nullptr_t, bool, char, uint64_t, double, std::string>;
+        // strings point into the code or into the arena of the program
+        using Variant = std::variant<std::nullptr_t, bool, char, uint64_t, double, std::string_view>;
 
         template <typename T>
         requires is_integer<T>
@@ -47,7 +49,10 @@ namespace cyntactic::ast {
         requires (!is_integer<T>)
         const T& get() { return  std::get<T>(mValue); }
 
-        std::string toString(bool compressed = true) const override;
+        const Variant& value() const { return mValue; }
+
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
+        static std::string str(const Variant& value);
 
     private:
         Variant mValue{nullptr};
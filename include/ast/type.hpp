@@ -25,7 +25,7 @@ namespace cyntactic::ast {
         const std::string_view& name() const { return mName; }
         bool isFloat() const { return mDetails.Float; }
         bool isSigned() const { return mDetails.Signed; }
-        std::string toString(bool compressed = true) const override;
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
     private:
         static const Details& getDetails(const std::string_view& tp, std::string_view& name);
         Details mDetails{};
@@ -0,0 +1,153 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <source.hpp>
+
+namespace cyntactic {
+
+    /**
+     * A problem found in the source, recorded as a code, a location and
+     * the few values its message needs. The message is only put together
+     * when the diagnostic is rendered, in the same format as a SyntaxError.
+     */
+    struct Diagnostic {
+        typedef enum {
+            WARNING,
+            ERROR
+        } Severity;
+
+        typedef enum {
+            D_LEXICAL,                  // {0} is the lexer's message
+            D_UNEXPECTED_CHAR,
+            D_EXPECTING_PRIMARY,
+            D_EXPECTING_OPERATOR,
+            D_EXPECTING_SEMICOLON,
+            D_EXPECTING_IDENTIFIER,
+            D_EXPECTING_IMPORT,
+            D_EXPECTING_MODULE,
+            D_EXPECTING_SYMBOLS,
+            D_EXPECTING_SYMBOLS_END,
+            D_EXPECTING_ALIAS,
+            D_IMPORT_TERMINATOR,
+            D_EXPECTING_BLOCK_END,
+            D_UNDEFINED_VARIABLE,
+            D_INTEGER_RANGE,
+            D_INTEGER_INVALID,
+            D_FLOAT_RANGE,
+            D_FLOAT_INVALID
+        } Code;
+
+        // strings must outlive the diagnostic, they normally point into the code
+        using Arg = std::variant<std::monostate, std::string_view, std::uint64_t, char>;
+        static constexpr std::size_t MaxArgs{3};
+
+        Code code{D_LEXICAL};
+        Severity severity{ERROR};
+        SourceLoc Loc{};
+        std::array<Arg, MaxArgs> Args{};
+
+        /**
+         * @return the message of \p code, {N} standing for the N-th argument
+         */
+        static std::string_view format(Code code);
+
+        /**
+         * Writes the message alone, without the location
+         */
+        void message(std::ostream& os) const;
+    };
+
+    /**
+     * Collects the diagnostics of a compilation. Reporting only copies a
+     * few words into a vector, nothing is formatted until the diagnostics
+     * are rendered against the sources their locations belong to.
+     *
+     * Diagnostics below the severity filter are dropped, as are repeats of
+     * a code already reported at the same location. Reports come mostly in
+     * source order, so repeats are only looked for among the diagnostics
+     * kept at or after the location, at the end of the vector. Once the
+     * error limit is reached further errors are only counted.
+     */
+    class DiagnosticEngine {
+    public:
+        using const_iterator = std::vector<Diagnostic>::const_iterator;
+
+        DiagnosticEngine() = default;
+
+        /**
+         * Records a diagnostic, arguments are stored as they are
+         * @return true if it was kept
+         */
+        template <typename... Args>
+        bool report(Diagnostic::Severity severity, Diagnostic::Code code, SourceLoc loc, Args&&... args)
+        {
+            static_assert(sizeof...(Args) <= Diagnostic::MaxArgs, "too many diagnostic arguments");
+            if (!admit(severity, code, loc)) {
+                return false;
+            }
+            mDiagnostics.push_back({code, severity, loc, {Diagnostic::Arg{std::forward<Args>(args)}...}});
+            return true;
+        }
+
+        /**
+         * Only keeps diagnostics at least as severe as \p minimum
+         */
+        void filter(Diagnostic::Severity minimum) { mMinimum = minimum; }
+
+        /**
+         * Keeps at most \p errors errors, 0 for no limit
+         */
+        void limit(std::size_t errors) { mLimit = errors; }
+
+        /**
+         * @return true once the error limit has been reached
+         */
+        bool full() const { return mLimit != 0 && mErrors >= mLimit; }
+
+        /**
+         * @return the number of errors reported, kept or not
+         */
+        std::size_t errors() const { return mErrors; }
+
+        std::size_t size() const { return mDiagnostics.size(); }
+        bool empty() const { return mDiagnostics.empty(); }
+        const_iterator begin() const { return mDiagnostics.begin(); }
+        const_iterator end() const { return mDiagnostics.end(); }
+        const Diagnostic& operator[](std::size_t i) const { return mDiagnostics[i]; }
+
+        /**
+         * Drops every diagnostic, the filter and the limit remain
+         */
+        void clear();
+
+        /**
+         * Writes \p diag as file:line:column: severity(syntax): message
+         */
+        static void render(std::ostream& os, const Diagnostic& diag, const SourceManager& sources);
+        static std::string render(const Diagnostic& diag, const SourceManager& sources);
+
+        /**
+         * Renders every diagnostic kept, one per line
+         */
+        void print(std::ostream& os, const SourceManager& sources) const;
+
+    private:
+        bool admit(Diagnostic::Severity severity, Diagnostic::Code code, SourceLoc loc);
+
+        std::vector<Diagnostic> mDiagnostics{};
+        Diagnostic::Severity mMinimum{Diagnostic::WARNING};
+        std::size_t mLimit{0};
+        std::size_t mErrors{0};
+    };
+}
@@ -0,0 +1,98 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <ast/binexpr.hpp>
+#include <ast/literal.hpp>
+#include <program.hpp>
+
+namespace cyntactic {
+
+    using NodeId = std::uint32_t;
+
+    /**
+     * A program's tree stored as parallel arrays indexed by NodeId, 17 bytes
+     * per node. Nodes are laid out breadth first so that the children of a
+     * node are the Counts[id] nodes starting at First[id], the root is the
+     * program. Payloads index the side table of the node's kind: Literals,
+     * Identifiers (ids in Names), the names of number Types, Imports or the
+     * BinaryOp of an expression.
+     *
+     * Walking the tree is a scan over contiguous arrays, and copying it is a
+     * handful of vector copies. Names and strings still point into the code,
+     * interner and arena of the program, which the flat tree keeps alive
+     * along with the sources its locations decode against.
+     */
+    class FlatAst {
+    public:
+        static constexpr NodeId Root{0};
+        static constexpr std::uint32_t None{UINT32_MAX};
+
+        struct Import {
+            Interner::Id Name{Interner::None};
+            Interner::Id Alias{Interner::None};
+            // the symbols are Identifiers[First, First + Count)
+            std::uint32_t First{0};
+            std::uint32_t Count{0};
+        };
+
+        FlatAst() = default;
+
+        /**
+         * Builds the flat copy of \p pg without recursing down its tree.
+         * The bodies of blocks skipped by a lazy parse are parsed on the
+         * way, their syntax errors are thrown from here.
+         */
+        static FlatAst flatten(const Program& pg);
+
+        std::size_t size() const { return Tags.size(); }
+        Node::Kind tag(NodeId id) const { return Node::Kind(Tags[id]); }
+        SourceLoc loc(NodeId id) const { return Locs[id]; }
+
+        /**
+         * @return the ids [first, last) of the children of \p id
+         */
+        std::pair<NodeId, NodeId> children(NodeId id) const { return {First[id], First[id] + Counts[id]}; }
+
+        const ast::Literal::Variant& literal(NodeId id) const { return Literals[Payloads[id]]; }
+        /**
+         * @return the name of an identifier or of a number type
+         */
+        std::string_view name(NodeId id) const;
+        const Import& import(NodeId id) const { return Imports[Payloads[id]]; }
+        const ast::BinaryOpInfo& op(NodeId id) const { return ast::BinaryOpInfo::of(ast::BinaryOp(Payloads[id])); }
+
+        /**
+         * @return the same text Node::toString() gives for the node
+         */
+        std::string str(NodeId id, bool compressed = true) const;
+
+        /**
+         * Prints the tree one node per line, indented by depth
+         */
+        void dump(std::ostream& os) const;
+
+        std::vector<std::uint8_t>  Tags{};
+        std::vector<NodeId>        First{};
+        std::vector<std::uint32_t> Counts{};
+        std::vector<SourceLoc>     Locs{};
+        std::vector<std::uint32_t> Payloads{};
+
+        std::vector<ast::Literal::Variant> Literals{};
+        std::vector<Interner::Id> Identifiers{};
+        std::vector<std::string_view> Types{};
+        std::vector<Import> Imports{};
+
+        SourceBuffer::Ptr Buffer{};
+        SourceManager::Ptr Sources{};
+        Interner::Ptr Names{};
+        Arena::Ptr Strings{};
+    };
+}
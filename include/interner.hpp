@@ -0,0 +1,54 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <arena.hpp>
+
+namespace cyntactic {
+
+    /**
+     * Per compilation table of unique names, each of which is handed a dense
+     * 32-bit id the first time it is seen. Tokens, AST nodes and symbols only
+     * carry the id, its text lives as long as the interner and never moves.
+     */
+    class Interner {
+    public:
+        using Id = std::uint32_t;
+        using Ptr = std::shared_ptr<Interner>;
+        static constexpr Id None{0};
+
+        Interner();
+        Interner(const Interner&) = delete;
+        Interner& operator=(const Interner&) = delete;
+
+        /**
+         * @return the id of \p name, adding it to the table if needed
+         */
+        Id intern(std::string_view name);
+
+        /**
+         * @return the id of \p name or None if it was never interned
+         */
+        Id find(std::string_view name) const;
+
+        std::string_view str(Id id) const { return mNames[id]; }
+        std::size_t size() const { return mNames.size() - 1; }
+
+    private cynt_ut:
+        static std::uint64_t hash(std::string_view name);
+    private:
+        void grow();
+
+        std::vector<std::string_view> mNames{};
+        std::vector<std::uint32_t> mHashes{};
+        std::vector<Id> mSlots{};
+        Arena mStorage{};
+    };
+}
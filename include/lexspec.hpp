@@ -0,0 +1,428 @@
+//
+// Created by Mpho Mbotho on 2021-08-22.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include <tokenizer.hpp>
+
+namespace cyntactic::lex {
+
+    struct Punctuator {
+        std::string_view Text;
+        Token::Kind      Kind;
+    };
+
+    /**
+     * Every punctuation and operator token known to the lexer. The character
+     * class and DFA tables used by Tokenizer::next are generated from this
+     * list at compile time, adding an operator only requires adding it here.
+     *
+     * Both comment openers lex as COMMENT and are then handed over to the
+     * comment scanners, `${` opens a string expression.
+     */
+    inline constexpr Punctuator Punctuators[] = {
+        {"{",   Token::LBRACE},
+        {"}",   Token::RBRACE},
+        {"(",   Token::LPAREN},
+        {")",   Token::RPAREN},
+        {"[",   Token::LBRACKET},
+        {"]",   Token::RBRACKET},
+        {"+",   Token::PLUS},
+        {"-",   Token::MINUS},
+        {"*",   Token::STAR},
+        {"/",   Token::SLASH},
+        {"@",   Token::COMPTIME},
+        {".",   Token::DOT},
+        {";",   Token::SEMICOLON},
+        {"&",   Token::AMPERSAND},
+        {"|",   Token::BAR},
+        {":",   Token::COLON},
+        {">",   Token::GREATER_THAN},
+        {"<",   Token::LESS_THAN},
+        {"=",   Token::EQUALS},
+        {",",   Token::COMMA},
+        {"%",   Token::PERCENT},
+        {"?",   Token::QUESTION},
+        {"^",   Token::CARET},
+        {"`",   Token::GRAVE},
+        {"~",   Token::TILDE},
+        {"!",   Token::EXCLAMATION},
+        {"->",  Token::RARROW},
+        {"<-",  Token::LARROW},
+        {"==",  Token::OP_EQ},
+        {"!=",  Token::OP_NEQ},
+        {">=",  Token::OP_GTE},
+        {"<=",  Token::OP_LTE},
+        {"+=",  Token::OP_PLUS_EQ},
+        {"-=",  Token::OP_MINUS_EQ},
+        {"*=",  Token::OP_MULT_EQ},
+        {"/=",  Token::OP_DIV_EQ},
+        {"%=",  Token::OP_MOD_EQ},
+        {"&=",  Token::OP_AND_EQ},
+        {"|=",  Token::OP_OR_EQ},
+        {"^=",  Token::OP_XOR_EQ},
+        {"<<",  Token::OP_LSHIFT},
+        {">>",  Token::OP_RSHIFT},
+        {"&&",  Token::OP_LAND},
+        {"||",  Token::OP_LOR},
+        {"++",  Token::OP_PLUS_PLUS},
+        {"--",  Token::OP_MINUS_MINUS},
+        {"::",  Token::OP_SCOPE},
+        {"..",  Token::OP_SEQUENCE},
+        {"...", Token::OP_ELIPSE},
+        {"<<=", Token::OP_LSHIFT_EQ},
+        {">>=", Token::OP_RSHIFT_EQ},
+        {"//",  Token::COMMENT},
+        {"/*",  Token::COMMENT},
+        {"${",  Token::STREXPR}
+    };
+
+    struct Keyword {
+        std::string_view Text;
+        Token::Kind      Kind;
+    };
+
+    /**
+     * Every reserved word, looked up through lex::keyword by a perfect hash
+     * that is generated from this list at compile time.
+     */
+    inline constexpr Keyword Keywords[] = {
+        {"if",        Token::IF},
+        {"in",        Token::IN},
+        {"as",        Token::AS},
+        {"for",       Token::FOR},
+        {"auto",      Token::AUTO},
+        {"case",      Token::CASE},
+        {"true",      Token::BOOL_LITERAL},
+        {"break",     Token::BREAK},
+        {"defer",     Token::DEFER},
+        {"false",     Token::BOOL_LITERAL},
+        {"raise",     Token::RAISE},
+        {"else",      Token::ELSE},
+        {"from",      Token::FROM},
+        {"func",      Token::FUNC},
+        {"void",      Token::VOID},
+        {"null",      Token::NONE},
+        {"this",      Token::THIS},
+        {"using",     Token::USING},
+        {"async",     Token::ASYNC},
+        {"await",     Token::AWAIT},
+        {"while",     Token::WHILE},
+        {"module",    Token::MODULE},
+        {"import",    Token::IMPORT},
+        {"native",    Token::NATIVE},
+        {"switch",    Token::SWITCH},
+        {"return",    Token::RETURN},
+        {"sizeof",    Token::SIZEOF},
+        {"struct",    Token::STRUCT},
+        {"continue",  Token::CONTINUE},
+        {"bool",      Token::BOOL_TYPE},
+        {"short",     Token::INT_TYPE},
+        {"ushort",    Token::INT_TYPE},
+        {"int",       Token::INT_TYPE},
+        {"uint",      Token::INT_TYPE},
+        {"long",      Token::INT_TYPE},
+        {"ulong",     Token::INT_TYPE},
+        {"byte",      Token::INT_TYPE},
+        {"char",      Token::INT_TYPE},
+        {"i8",        Token::INT_TYPE},
+        {"u8",        Token::INT_TYPE},
+        {"i16",       Token::INT_TYPE},
+        {"u16",       Token::INT_TYPE},
+        {"i32",       Token::INT_TYPE},
+        {"u32",       Token::INT_TYPE},
+        {"i64",       Token::INT_TYPE},
+        {"u64",       Token::INT_TYPE},
+        {"f32",       Token::FLOAT_TYPE},
+        {"f64",       Token::FLOAT_TYPE},
+        {"string",    Token::STR_TYPE},
+        {"code",      Token::CODE_TYPE}
+    };
+
+    /**
+     * What a token starting with a given byte can be, used to dispatch
+     * from Tokenizer::next
+     */
+    typedef enum : std::uint8_t {
+        L_INVALID,
+        L_SPACE,
+        L_ZERO,
+        L_DIGIT,
+        L_IDENT,
+        L_STRING,
+        L_CHAR,
+        L_PUNCT,
+        L_UTF8                  // any byte >= 0x80, the lead of a non-ASCII character
+    } LeadKind;
+
+    /**
+     * Character properties used by the scanners
+     */
+    enum : std::uint8_t {
+        F_SPACE     = 0x01,
+        F_DIGIT     = 0x02,
+        F_HEX       = 0x04,
+        F_OCTAL     = 0x08,
+        F_IDENT     = 0x10,
+        F_ESCAPABLE = 0x20
+    };
+
+    struct CharInfo {
+        LeadKind     Lead{L_INVALID};
+        std::uint8_t Class{0};
+        std::uint8_t Flags{0};
+        char         Escape{0};
+    };
+
+    namespace detail {
+
+        constexpr std::size_t countStates()
+        {
+            // the number of distinct prefixes plus the start state
+            std::size_t count{1};
+            for (std::size_t i = 0; i < std::size(Punctuators); i++) {
+                for (std::size_t len = 1; len <= Punctuators[i].Text.size(); len++) {
+                    auto prefix = Punctuators[i].Text.substr(0, len);
+                    bool seen{false};
+                    for (std::size_t j = 0; j < i && !seen; j++) {
+                        seen = Punctuators[j].Text.substr(0, len) == prefix &&
+                               Punctuators[j].Text.size() >= len;
+                    }
+                    count += !seen;
+                }
+            }
+            return count;
+        }
+
+        constexpr std::size_t countClasses()
+        {
+            // class 0 is reserved for bytes that never appear in a punctuator
+            std::array<bool, 256> used{};
+            std::size_t count{1};
+            for (const auto& p: Punctuators) {
+                for (auto c: p.Text) {
+                    if (!used[std::uint8_t(c)]) {
+                        used[std::uint8_t(c)] = true;
+                        count++;
+                    }
+                }
+            }
+            return count;
+        }
+    }
+
+    inline constexpr std::size_t States  = detail::countStates();
+    inline constexpr std::size_t Classes = detail::countClasses();
+
+    struct Tables {
+        std::array<CharInfo, 256> Chars{};
+        std::array<std::array<std::uint8_t, Classes>, States> Next{};
+        std::array<Token::Kind, States> Accept{};
+    };
+
+    namespace detail {
+
+        constexpr Tables buildTables()
+        {
+            Tables t{};
+            for (unsigned c = 0; c < 256; c++) {
+                auto& info = t.Chars[c];
+                if (c == ' ' || (c >= '\t' && c <= '\r')) {
+                    info.Lead = L_SPACE;
+                    info.Flags |= F_SPACE;
+                }
+                else if (c >= '0' && c <= '9') {
+                    info.Lead = (c == '0')? L_ZERO : L_DIGIT;
+                    info.Flags |= F_DIGIT | F_HEX | F_IDENT | ((c <= '7')? F_OCTAL : 0);
+                }
+                else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+                    info.Lead = L_IDENT;
+                    info.Flags |= F_IDENT | (((c | 0x20) >= 'a' && (c | 0x20) <= 'f')? F_HEX : 0);
+                }
+                else if (c == '"') {
+                    info.Lead = L_STRING;
+                }
+                else if (c == '\'') {
+                    info.Lead = L_CHAR;
+                }
+                else if (c >= 0x80) {
+                    info.Lead = L_UTF8;
+                }
+            }
+            constexpr std::string_view escapes{"bfnrtv\\'\"?0"};
+            constexpr std::string_view decoded{"\b\f\n\r\t\v\\'\"?\0", escapes.size()};
+            for (std::size_t i = 0; i < escapes.size(); i++) {
+                auto& info = t.Chars[std::uint8_t(escapes[i])];
+                info.Flags |= F_ESCAPABLE;
+                info.Escape = decoded[i];
+            }
+            // only valid in strings, where it keeps a '$' from opening a string expression
+            t.Chars[std::uint8_t('$')].Escape = '$';
+
+            std::uint8_t classes{1};
+            for (const auto& p: Punctuators) {
+                auto& lead = t.Chars[std::uint8_t(p.Text[0])];
+                lead.Lead = L_PUNCT;
+                for (auto c: p.Text) {
+                    auto& info = t.Chars[std::uint8_t(c)];
+                    if (info.Class == 0) info.Class = classes++;
+                }
+            }
+
+            std::uint8_t states{1};
+            for (auto& kind: t.Accept) kind = Token::T_EOF;
+            for (const auto& p: Punctuators) {
+                std::uint8_t state{0};
+                for (auto c: p.Text) {
+                    auto& next = t.Next[state][t.Chars[std::uint8_t(c)].Class];
+                    if (next == 0) next = states++;
+                    state = next;
+                }
+                t.Accept[state] = p.Kind;
+            }
+            return t;
+        }
+
+        constexpr bool prefixClosed(const Tables& t)
+        {
+            // Longest match never needs to backtrack if every state past the first
+            // byte accepts, a lone first byte is reported as unexpected otherwise
+            std::array<bool, States> first{};
+            for (auto next: t.Next[0]) first[next] = true;
+            for (std::size_t s = 1; s < States; s++) {
+                if (first[s] || t.Accept[s] != Token::T_EOF) continue;
+                for (auto next: t.Next[s]) {
+                    if (next != 0) return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    inline constexpr Tables Table = detail::buildTables();
+
+    static_assert(States < 256, "lexer DFA state must fit in a byte");
+    static_assert(detail::prefixClosed(Table), "every multi-byte punctuator prefix must be a token");
+
+    namespace detail {
+
+        /**
+         * Packs the bytes that tell keywords apart (first, second and last
+         * character plus the length) into the key fed to the hash
+         */
+        constexpr std::uint32_t keywordKey(std::string_view word)
+        {
+            return std::uint32_t(std::uint8_t(word[0])) |
+                   std::uint32_t(std::uint8_t(word[1])) << 8 |
+                   std::uint32_t(std::uint8_t(word.back())) << 16 |
+                   std::uint32_t(word.size()) << 24;
+        }
+
+        struct KeywordTable {
+            static constexpr unsigned Bits = 8;
+            static constexpr std::uint8_t Empty = 0xFF;
+            std::uint32_t Multiplier{0};
+            std::size_t   MinLength{~std::size_t{0}};
+            std::size_t   MaxLength{0};
+            std::array<std::uint8_t, 1u << Bits> Slots{};
+
+            constexpr unsigned slot(std::string_view word) const
+            {
+                return (keywordKey(word) * Multiplier) >> (32 - Bits);
+            }
+        };
+
+        constexpr KeywordTable buildKeywordTable()
+        {
+            static_assert(std::size(Keywords) < KeywordTable::Empty);
+            KeywordTable t{};
+            for (const auto& kw: Keywords) {
+                t.MinLength = std::min(t.MinLength, kw.Text.size());
+                t.MaxLength = std::max(t.MaxLength, kw.Text.size());
+            }
+
+            // search odd multipliers along the golden ratio sequence until one is collision free
+            for (std::uint32_t seed = 1; seed < 0x10000; seed += 2) {
+                t.Multiplier = seed * 0x9E3779B1u;
+                for (auto& slot: t.Slots) slot = KeywordTable::Empty;
+                bool perfect{true};
+                for (std::size_t i = 0; i < std::size(Keywords) && perfect; i++) {
+                    auto& slot = t.Slots[t.slot(Keywords[i].Text)];
+                    perfect = (slot == KeywordTable::Empty);
+                    slot = std::uint8_t(i);
+                }
+                if (perfect) return t;
+            }
+            t.Multiplier = 0;
+            return t;
+        }
+    }
+
+    inline constexpr detail::KeywordTable KeywordHash = detail::buildKeywordTable();
+
+    static_assert(KeywordHash.Multiplier != 0, "no perfect hash found for the keyword list");
+    static_assert(KeywordHash.MinLength >= 2, "keyword hash reads the second character");
+
+    /**
+     * @return the kind of the keyword spelled by \p word or IDENTIFIER if it
+     * is not a keyword
+     */
+    constexpr Token::Kind keyword(std::string_view word)
+    {
+        if (word.size() < KeywordHash.MinLength || word.size() > KeywordHash.MaxLength) {
+            return Token::IDENTIFIER;
+        }
+        auto index = KeywordHash.Slots[KeywordHash.slot(word)];
+        if (index != detail::KeywordTable::Empty && Keywords[index].Text == word) {
+            return Keywords[index].Kind;
+        }
+        return Token::IDENTIFIER;
+    }
+
+    static_assert(keyword("continue") == Token::CONTINUE && keyword("func") == Token::FUNC);
+    static_assert(keyword("i65") == Token::IDENTIFIER && keyword("x") == Token::IDENTIFIER);
+
+    inline const CharInfo& info(char c)
+    {
+        return Table.Chars[std::uint8_t(c)];
+    }
+
+    inline bool is(char c, std::uint8_t flags)
+    {
+        return (info(c).Flags & flags) != 0;
+    }
+
+    /**
+     * @return the character denoted by the escape sequence `\\c`, only
+     * meaningful if \p c is F_ESCAPABLE
+     */
+    inline char unescape(char c)
+    {
+        return info(c).Escape;
+    }
+
+    /**
+     * Decodes the escape sequences in the text of a string literal, as
+     * validated by the tokenizer, into \p out. Decoding never makes the
+     * text longer, \p out must have room for \p raw.size() bytes.
+     * @return the number of bytes written to \p out
+     */
+    inline std::size_t unescape(std::string_view raw, char *out)
+    {
+        std::size_t n{0}, from{0};
+        for (auto at = raw.find('\\'); at != std::string_view::npos; at = raw.find('\\', from)) {
+            raw.copy(out + n, at - from, from);
+            n += at - from;
+            out[n++] = unescape(raw[at + 1]);
+            from = at + 2;
+        }
+        raw.copy(out + n, raw.size() - from, from);
+        return n + raw.size() - from;
+    }
+}
@@ -0,0 +1,34 @@
+//
+// Created by Mpho Mbotho on 2021-08-23.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cyntactic {
+
+    /**
+     * The offset at which every line of a source starts, used to turn byte
+     * offsets into a line and column only when a location is printed
+     */
+    class LineIndex {
+    public:
+        LineIndex() = default;
+        explicit LineIndex(std::string_view code);
+
+        bool empty() const { return mStarts.empty(); }
+        std::size_t lines() const { return mStarts.size(); }
+
+        /**
+         * @return the 1-based line and column of the byte at \p offset
+         */
+        std::pair<std::size_t, std::size_t> location(std::size_t offset) const;
+
+    private:
+        std::vector<std::uint32_t> mStarts{};
+    };
+}
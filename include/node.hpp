@@ -4,22 +4,124 @@
 
 #pragma once
 
-#include <list>
+#include <cstdint>
 #include <memory>
+#include <new>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
+#include <arena.hpp>
+#include <interner.hpp>
+#include <source.hpp>
 #include <textbox.hpp>
 
 namespace cyntactic {
 
+    struct Node;
+
+    /**
+     * Owns every node of a program along with their child arrays, all of
+     * which are released at once when the arena goes away. Only the few
+     * node types that own memory of their own are destroyed one by one,
+     * in a flat loop rather than down the tree.
+     */
+    class AstArena {
+    public:
+        using Ptr = std::shared_ptr<AstArena>;
+
+        AstArena() = default;
+        AstArena(const AstArena&) = delete;
+        AstArena& operator=(const AstArena&) = delete;
+        ~AstArena();
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args)
+        {
+            auto *node = new (mMemory.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                mFinalizers.push_back({node, [](void *p) { static_cast<T*>(p)->~T(); }});
+            }
+            if constexpr (std::is_base_of_v<Node, T>) {
+                mNodes++;
+            }
+            return node;
+        }
+
+        void* allocate(std::size_t size, std::size_t align) { return mMemory.allocate(size, align); }
+
+        /**
+         * @return the number of nodes made so far
+         */
+        std::size_t nodes() const { return mNodes; }
+
+    private:
+        struct Finalizer {
+            void *Object;
+            void (*Destroy)(void*);
+        };
+
+        Arena mMemory{};
+        std::vector<Finalizer> mFinalizers{};
+        std::size_t mNodes{0};
+    };
+
+    /**
+     * The children of a node. Up to Inline children are stored in the
+     * list itself, more spill into an array in the AST arena which is
+     * replaced by one twice as large when full.
+     */
+    class NodeList {
+    public:
+        using const_iterator = Node* const*;
+        static constexpr std::uint32_t Inline{2};
+
+        std::size_t size() const { return mSize; }
+        bool empty() const { return mSize == 0; }
+        const_iterator begin() const { return data(); }
+        const_iterator end() const { return data() + mSize; }
+        Node* front() const { return data()[0]; }
+        Node* back() const { return data()[mSize - 1]; }
+        Node* operator[](std::size_t i) const { return data()[i]; }
+
+        /**
+         * Appends \p node, growing into \p arena once the inline slots are taken
+         */
+        void push_back(Node *node, AstArena& arena)
+        {
+            if (mSize == mCapacity) {
+                grow(arena);
+            }
+            data()[mSize++] = node;
+        }
+
+        /**
+         * Appends \p node to a list known to have room for it
+         */
+        void push_back(Node *node) { data()[mSize++] = node; }
+
+    private:
+        Node* const* data() const { return (mCapacity > Inline)? mHeap : mInline; }
+        Node** data() { return (mCapacity > Inline)? mHeap : mInline; }
+        void grow(AstArena& arena);
+
+        union {
+            Node *mInline[Inline]{};
+            Node **mHeap;
+        };
+        std::uint32_t mSize{0};
+        std::uint32_t mCapacity{Inline};
+    };
+
+    /**
+     * Nodes live in an AstArena and are destroyed as their own type,
+     * never through a Node pointer
+     */
     struct Node {
-        using Ptr = std::unique_ptr<Node>;
-        using GraphIt = std::pair<
-                            std::list<Ptr>::const_iterator,
-                            std::list<Ptr>::const_iterator>;
+        using Ptr = Node*;
+        using GraphIt = std::pair<NodeList::const_iterator, NodeList::const_iterator>;
 
         typedef enum {
             INVALID,
@@ -29,17 +131,22 @@ namespace cyntactic {
             NUMBER_TYPE,
             LITERAL,
             BINARY_OP,
-            BINARY_EXPR
+            BINARY_EXPR,
+            BLOCK,
+            ERROR
         } Kind;
 
         Node() = default;
         Node(Kind kind) : Tag{kind} {}
-        std::list<Ptr> Children;
+        NodeList Children;
         Kind   Tag{INVALID};
-        std::string_view Source{};
-        std::size_t Line{0};
-        std::size_t Column{0};
-        virtual std::string toString(bool compressed = true) const { return ""; }
+        // where the node's first token starts
+        SourceLoc Loc{};
+        /**
+         * @param names the interner of the node's program, without it
+         * names are printed as their id
+         */
+        virtual std::string toString(bool compressed = true, const Interner *names = nullptr) const { return ""; }
     };
 }
 
@@ -47,14 +154,14 @@ namespace cyntactic {
 namespace cyntactic {
 
     template <>
-    Node::GraphIt TreeGraph<Node>::countChildren() const;
+    Node::GraphIt TreeGraph<Node, const Interner*>::countChildren() const;
 
     template <>
-    bool TreeGraph<Node>::isOneliner() const;
+    bool TreeGraph<Node, const Interner*>::isOneliner() const;
 
     template <>
-    const Node& TreeGraph<Node>::getNode(const Iterator& it) const;
+    const Node& TreeGraph<Node, const Interner*>::getNode(const Iterator& it) const;
 
     template <>
-    std::string TreeGraph<Node>::createAtom() const;
+    std::string TreeGraph<Node, const Interner*>::createAtom() const;
 }
@@ -0,0 +1,33 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace cyntactic::num {
+
+    typedef enum {
+        N_OK,
+        N_OUT_OF_RANGE,
+        N_INVALID
+    } Status;
+
+    /**
+     * Converts the text of an integer literal, as produced by the tokenizer,
+     * to its value. Hexadecimal and binary literals may keep their 0x/0b
+     * prefix. Nothing is allocated and the conversion is locale independent.
+     * @return N_OK, or N_OUT_OF_RANGE if the literal does not fit 64 bits
+     */
+    Status integer(std::string_view text, int base, std::uint64_t& value);
+
+    /**
+     * Converts the text of a decimal (1.5e3) or hexadecimal (0x1.8p3)
+     * floating point literal to its value
+     * @return N_OK, N_OUT_OF_RANGE if the literal cannot be represented or
+     * N_INVALID if it is not a floating point literal
+     */
+    Status real(std::string_view text, double& value);
+}
@@ -7,7 +7,12 @@
 #include <filesystem>
 #include <functional>
 
+#include <ast/binexpr.hpp>
+#include <ast/block.hpp>
+#include <diagnostics.hpp>
+#include <pipeline.hpp>
 #include <program.hpp>
+#include <symbols.hpp>
 #include <tokenizer.hpp>
 #include <parser.hpp>
 
@@ -27,37 +32,106 @@ namespace cyntactic {
          Program parse(const std::filesystem::path& src);
 
         /**
-         * Parses the code contained in the given \p code string
+         * Parses the code contained in the given \p code string, in place
+         * and with bounds checks. The code must outlive the program, parse
+         * a SourceBuffer::copy of it for the program to own a padded copy.
          * @param code the code to parse
          * @param src the source file from which the code come from
          * @return the parsed source syntax tree
          */
         Program parse(const std::string_view& code, const std::string_view& src);
 
+        /**
+         * Parses an already loaded source buffer, the program keeps it alive
+         */
+        Program parse(SourceBuffer::Ptr source);
+
+        /**
+         * @return the problems reported by the last parse that did not stop
+         * it, which ends early once the error limit is reached. Filters and
+         * limits set on the engine hold for every parse.
+         */
+        const DiagnosticEngine& diagnostics() const { return mDiagnostics; }
+        DiagnosticEngine& diagnostics() { return mDiagnostics; }
+
+        /**
+         * When enabled, the code is lexed on a separate thread while it is
+         * being parsed instead of being tokenized in full up front. Worth it
+         * for large inputs on a machine with a core to spare.
+         */
+        void pipelined(bool enabled) { mPipelined = enabled; }
+
+        /**
+         * When enabled, a syntax error no longer stops the parse. It is added
+         * to the diagnostics, the statement it is in is replaced by an
+         * ast::Error node and parsing resumes after the next ';' or '}', or
+         * at the next import, func or struct. Lexical errors are reported
+         * the same way, so one parse reports every broken statement.
+         */
+        void recover(bool enabled) { mRecover = enabled; }
+
+        /**
+         * When enabled, the body of a block is skipped by a scan for its
+         * closing brace instead of being lexed and parsed, and is left to
+         * be parsed on first access through ast::Block::body(). Meant for
+         * code of which only the declarations matter. The code is lexed as
+         * it is parsed, pipelined() is ignored.
+         */
+        void lazy(bool enabled) { mLazy = enabled; }
+
+        /**
+         * Parses the body of \p block, skipped by a lazy parse, into the
+         * program the block belongs to and the way the program was parsed.
+         * Blocks within it are skipped too, problems found in it are
+         * reported into the program's Diagnostics.
+         */
+        void expand(ast::Block& block);
+
+        /**
+         * Shares the location space of \p sources, so that the locations of
+         * programs parsed separately can be told apart. It keeps every
+         * source parsed alive. Otherwise each parse starts a location space
+         * of its own, which the program keeps alive.
+         */
+        void sources(SourceManager::Ptr sources)
+        {
+            mSources = std::move(sources);
+            mShared = mSources != nullptr;
+        }
+
     private:
+        void statements(NodeList& list);
+        Node::Ptr statement();
+        Node::Ptr block();
+        Node::Ptr synchronize(std::size_t start);
         Node::Ptr importExpr();
         Node::Ptr primaryExpr();
-        Node::Ptr binaryExpr(unsigned precedence = 0);
+        Node::Ptr binaryExpr();
         Node::Ptr integerLiteral(int base);
+        Node::Ptr floatLiteral();
         Node::Ptr charLiteral();
         Node::Ptr stringLiteral();
         Node::Ptr boolLiteral();
 
     private:
         using TokenFunc = std::function<void(const Token&)>;
+        // unwinds a statement that failed to parse, its error is already reported
+        struct Abandon {};
 
-        void advance(bool eatWs = false);
-        Node::Ptr advance(Node::Ptr&& node, bool eatWs = false);
-        bool is(Token::Kind kind) const { return mLookahead.kind == kind; }
-        void eatWhiteSpace();
+        void advance();
+        void lex();
+        Node::Ptr advance(Node::Ptr node);
+        bool is(Token::Kind kind) const { return mTokens.kind(mIndex) == kind; }
         void commaSeperatedIdentifier(TokenFunc onIdent);
 
         template<typename ...Args>
-        void syntaxError(Args&... args);
+        void syntaxError(Diagnostic::Code code, Args&&... args);
+        template<typename ...Args>
+        void error(Diagnostic::Code code, Args&&... args);
         template<typename... T>
-        void expect(const std::string_view& msg, Token::Kind kind, T&&... kinds);
+        void expect(Diagnostic::Code code, Token::Kind kind, T&&... kinds);
         template<typename... T>
-        void expectAdvance(const std::string_view& msg, Token::Kind kind, T&&... kinds);
+        void expectAdvance(Diagnostic::Code code, Token::Kind kind, T&&... kinds);
         template<typename... T>
         bool expectCheck(Token::Kind kind, T&&... kinds);
 
@@ -65,6 +139,30 @@ namespace cyntactic {
         Node::Ptr mkNode(Args&&... args);
 
         Tokenizer mTokenizer;
+        Interner::Ptr mNames{};
+        // keyed by the ids of mNames, so started afresh with it
+        SymTable mSymbols{};
+        SourceManager::Ptr mSources{};
+        // set when the location space outlives a single parse
+        bool mShared{false};
+        // the location of the first byte of the code being parsed
+        SourceLoc mBase{};
+        Arena::Ptr mStrings{};
+        AstArena::Ptr mNodes{};
+        TokenBuffer mTokens{};
+        bool mPipelined{false};
+        bool mRecover{false};
+        bool mLazy{false};
+        // shared by the blocks skipped by a lazy parse
+        ast::Block::Context *mContext{nullptr};
+        // the number of blocks the parser is in
+        std::size_t mDepth{0};
+        // while pipelined, mTokens is the current batch of tokens
+        std::unique_ptr<TokenPipeline> mPipeline{};
+        std::size_t mIndex{0};
+        // operators of the expressions being parsed still waiting for their right operand
+        std::vector<std::pair<ast::BinaryOpInfo, Node::Ptr>> mPending{};
         Token mLookahead{};
+        DiagnosticEngine mDiagnostics{};
     };
 }
\ No newline at end of file
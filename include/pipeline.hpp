@@ -0,0 +1,71 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <exception>
+#include <thread>
+
+#include <spsc.hpp>
+#include <tokenizer.hpp>
+
+namespace cyntactic {
+
+    /**
+     * Lexes a source buffer on a thread of its own while a single consumer,
+     * the parser, works through the tokens lexed so far. Tokens are handed
+     * over in batches through a bounded queue, the lexer stops when it runs
+     * Depth batches ahead and batches the consumer is done with are reused.
+     *
+     * A lexical error ends the stream: the consumer first gets the tokens
+     * lexed before it, the error is rethrown by the next call to next().
+     */
+    class TokenPipeline {
+    public:
+        static constexpr std::size_t BatchSize{4096};
+        static constexpr std::size_t Depth{8};
+
+        /**
+         * Starts lexing \p source right away, identifiers are interned into
+         * \p names from the lexer thread so the consumer must not use the
+         * interner until the stream has ended. With \p recover lexical errors
+         * are handed out as ERROR tokens rather than ending the stream.
+         */
+        TokenPipeline(const SourceBuffer& source, Interner *names,
+                      std::size_t batch = BatchSize, bool recover = false);
+        TokenPipeline(const TokenPipeline&) = delete;
+        TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+        /**
+         * Stops the lexer, even if it is blocked on a full queue
+         */
+        ~TokenPipeline();
+
+        /**
+         * Replaces \p tokens, the batch handed out by the previous call if
+         * any, with the next batch. Offsets are relative to the whole code,
+         * the last batch ends with T_EOF and every call after it hands out
+         * a lone T_EOF.
+         */
+        void next(TokenBuffer& tokens);
+
+    private:
+        struct Batch {
+            TokenBuffer Tokens{};
+            std::exception_ptr Error{};
+        };
+
+        void produce();
+
+        SpscQueue<Batch, Depth> mFull{};
+        SpscQueue<TokenBuffer, Depth> mFree{};
+        Tokenizer mTokenizer;
+        std::string_view mCode{};
+        std::size_t mBatch{BatchSize};
+        std::exception_ptr mError{};
+        bool mHolding{false};
+        bool mEnded{false};
+        std::thread mThread{};
+    };
+}
@@ -7,7 +7,11 @@
 #include <string>
 #include <ostream>
 
+#include <arena.hpp>
+#include <diagnostics.hpp>
+#include <interner.hpp>
 #include <node.hpp>
+#include <source.hpp>
 
 namespace cyntactic {
 
@@ -15,7 +19,20 @@ namespace cyntactic {
     public:
         Program() : Node(Node::PROGRAM){};
         void dump(std::ostream& os) const;
+        SourceManager::Location location(const Node& node) const { return Sources->decode(node.Loc); }
+        // keeps the code the nodes of the program point into alive
+        SourceBuffer::Ptr Buffer{};
+        // decodes the locations of the nodes
+        SourceManager::Ptr Sources{};
+        // the names the identifiers of the program were interned into
+        Interner::Ptr Names{};
+        // string literals with escapes, decoded ones cannot point into Buffer
+        Arena::Ptr Strings{};
+        // every node below the program
+        AstArena::Ptr Nodes{};
+        // the problems found parsing the blocks a lazy parse skipped, null otherwise
+        std::shared_ptr<DiagnosticEngine> Diagnostics{};
     protected:
-        std::string toString(bool compressed = true) const override;
+        std::string toString(bool compressed = true, const Interner *names = nullptr) const override;
     };
 }
@@ -0,0 +1,106 @@
+//
+// Created by Mpho Mbotho on 2021-08-21.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cyntactic::scan {
+
+    /**
+     * The instruction set used by the run scanning kernels. The best
+     * supported set is picked at runtime the first time a kernel is used.
+     */
+    typedef enum {
+        SCALAR,
+        SSE2,
+        AVX2
+    } Isa;
+
+    struct Kernels {
+        using Span    = const char* (*)(const char *p, const char *end);
+        using Find    = const char* (*)(const char *p, const char *end, char c);
+        using Count   = std::size_t (*)(const char *p, const char *end, char c);
+        using Collect = void (*)(const char *p, const char *end, char c, std::vector<std::uint32_t>& out);
+
+        Span    whitespace;
+        Span    identifier;
+        Span    utf8;
+        Find    find;
+        Count   count;
+        Collect collect;
+    };
+
+    extern Kernels gKernels;
+
+    /**
+     * @return the instruction set backing the current kernels
+     */
+    Isa isa();
+
+    /**
+     * Forces the kernels to the given instruction set, falling back to the
+     * best one supported by the running CPU if \p isa is not available
+     * @return the instruction set that was actually selected
+     */
+    Isa select(Isa isa);
+
+    std::string_view name(Isa isa);
+
+    /**
+     * @return a pointer to the first byte in [p, end) that is not a white
+     * space character (' ', '\t', '\n', '\v', '\f', '\r') or \p end
+     */
+    inline const char* whitespace(const char *p, const char *end)
+    {
+        return gKernels.whitespace(p, end);
+    }
+
+    /**
+     * @return a pointer to the first byte in [p, end) that is not in
+     * [A-Za-z0-9_] or \p end
+     */
+    inline const char* identifier(const char *p, const char *end)
+    {
+        return gKernels.identifier(p, end);
+    }
+
+    /**
+     * @return a pointer to the first byte of the first sequence in [p, end)
+     * that is not well formed UTF-8 or \p end. A sequence cut short by
+     * \p end is not well formed.
+     */
+    inline const char* utf8(const char *p, const char *end)
+    {
+        return gKernels.utf8(p, end);
+    }
+
+    /**
+     * @return a pointer to the first occurrence of \p c in [p, end) or \p end
+     */
+    inline const char* find(const char *p, const char *end, char c)
+    {
+        return gKernels.find(p, end, c);
+    }
+
+    /**
+     * @return the number of occurrences of \p c in [p, end)
+     */
+    inline std::size_t count(const char *p, const char *end, char c)
+    {
+        return gKernels.count(p, end, c);
+    }
+
+    /**
+     * Appends the offset (relative to \p p) of every occurrence of \p c in
+     * [p, end) to \p out
+     */
+    inline void collect(const char *p, const char *end, char c, std::vector<std::uint32_t>& out)
+    {
+        gKernels.collect(p, end, c, out);
+    }
+}
@@ -0,0 +1,137 @@
+//
+// Created by Mpho Mbotho on 2021-08-24.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <lines.hpp>
+
+namespace cyntactic {
+
+    /**
+     * Owns the bytes of a source file. Regular files are memory mapped so
+     * that tokens and AST nodes can point straight into the mapping, pipes
+     * and special files are read into memory instead. Either way the code is
+     * followed by Padding NUL bytes, so the tokenizer may read past its end.
+     * A buffer that only views code owned by the caller is not padded.
+     */
+    class SourceBuffer {
+    public:
+        using Ptr = std::shared_ptr<const SourceBuffer>;
+        static constexpr std::size_t Padding{64};
+
+        /**
+         * Loads the file at the given path
+         * @param path the file to load
+         * @return the loaded source buffer
+         * @throws Exception if the file cannot be opened or read
+         */
+        static Ptr open(const std::filesystem::path& path);
+
+        /**
+         * @return a padded copy of \p code, named \p name
+         */
+        static Ptr copy(std::string_view code, std::string name);
+
+        /**
+         * @return an unpadded buffer over \p code, which must outlive it
+         */
+        static Ptr view(std::string_view code, std::string name);
+
+        SourceBuffer(const SourceBuffer&) = delete;
+        SourceBuffer& operator=(const SourceBuffer&) = delete;
+        ~SourceBuffer();
+
+        std::string_view code() const { return {mData, mSize}; }
+        const std::string& name() const { return mName; }
+        bool mapped() const { return mMapped; }
+        bool padded() const { return mPadded; }
+
+    private:
+        explicit SourceBuffer(std::string name)
+            : mName{std::move(name)}
+        {}
+
+        std::string mName{};
+        std::string mStorage{};
+        const char *mData{nullptr};
+        std::size_t mSize{0};
+        std::size_t mMapSize{0};
+        bool mMapped{false};
+        bool mPadded{true};
+    };
+
+    /**
+     * A position in any of the sources of a compilation, encoded as one
+     * offset into the space the SourceManager spreads its files over.
+     * 0 is no location.
+     */
+    struct SourceLoc {
+        std::uint32_t Raw{0};
+
+        SourceLoc operator+(std::size_t offset) const { return {Raw + std::uint32_t(offset)}; }
+        bool operator==(const SourceLoc&) const = default;
+        explicit operator bool() const { return Raw != 0; }
+    };
+
+    /**
+     * Hands every source buffer of a compilation a range of a single 32-bit
+     * location space, one byte longer than the buffer so that its end has
+     * a location too. Locations are only turned back into a file, line and
+     * column when printed, the line index of a file is built the first
+     * time one of its locations is decoded.
+     */
+    class SourceManager {
+    public:
+        using Ptr = std::shared_ptr<SourceManager>;
+
+        struct Location {
+            std::string_view File{};
+            std::size_t Line{0};
+            std::size_t Column{0};
+        };
+
+        /**
+         * Adds \p buffer, which is kept alive by the manager
+         * @return the location of the buffer's first byte
+         * @throws Exception once the location space is exhausted
+         */
+        SourceLoc add(SourceBuffer::Ptr buffer);
+
+        /**
+         * @return the buffer \p loc points into and the offset within it,
+         * or a null buffer if \p loc was not handed out by this manager
+         */
+        std::pair<const SourceBuffer*, std::size_t> find(SourceLoc loc) const;
+
+        /**
+         * @return the file, line and column of \p loc, an empty file name
+         * and line 0 if \p loc was not handed out by this manager
+         */
+        Location decode(SourceLoc loc) const;
+
+        std::size_t files() const;
+
+    private:
+        struct File {
+            std::uint32_t Base{0};
+            SourceBuffer::Ptr Buffer{};
+            LineIndex Lines{};
+        };
+
+        File* file(SourceLoc loc) const;
+
+        mutable std::mutex mLock{};
+        // ordered by base
+        mutable std::vector<File> mFiles{};
+        std::uint32_t mNext{1};
+    };
+}
@@ -0,0 +1,141 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace cyntactic {
+
+    /**
+     * Bounded lock-free queue between exactly one producer thread and one
+     * consumer thread. Each side only writes its own index and caches the
+     * other's, so the indices are only shared when the queue looks full
+     * (or empty). The blocking calls spin briefly before sleeping on an
+     * event counter both sides bump after every operation.
+     */
+    template <typename T, std::size_t Capacity>
+    class SpscQueue {
+        static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of 2");
+    public:
+        SpscQueue() = default;
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        /**
+         * Producer side, \p value is left untouched if the queue is full
+         * @return true if \p value was queued
+         */
+        bool tryPush(T&& value)
+        {
+            auto tail = mTail.load(std::memory_order_relaxed);
+            if (tail - mHeadCache == Capacity) {
+                mHeadCache = mHead.load(std::memory_order_acquire);
+                if (tail - mHeadCache == Capacity) {
+                    return false;
+                }
+            }
+            mSlots[tail & (Capacity - 1)] = std::move(value);
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Consumer side
+         * @return true if a value was moved into \p value
+         */
+        bool tryPop(T& value)
+        {
+            auto head = mHead.load(std::memory_order_relaxed);
+            if (head == mTailCache) {
+                mTailCache = mTail.load(std::memory_order_acquire);
+                if (head == mTailCache) {
+                    return false;
+                }
+            }
+            value = std::move(mSlots[head & (Capacity - 1)]);
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Waits for room in the queue, this is the producer's backpressure
+         * @return false if the queue was closed before \p value could be queued
+         */
+        bool push(T&& value)
+        {
+            if (closed() || !await([&] { return tryPush(std::move(value)); })) {
+                return false;
+            }
+            signal();
+            return true;
+        }
+
+        /**
+         * Waits for a value, values queued before the queue was closed are
+         * still handed out
+         * @return false once the queue is closed and empty
+         */
+        bool pop(T& value)
+        {
+            if (!await([&] { return tryPop(value); })) {
+                return false;
+            }
+            signal();
+            return true;
+        }
+
+        /**
+         * Wakes up and fails every blocked or future push(), and pop() once
+         * the queue is drained
+         */
+        void close()
+        {
+            mClosed.store(true, std::memory_order_release);
+            signal();
+        }
+
+        bool closed() const { return mClosed.load(std::memory_order_acquire); }
+
+    private:
+        static constexpr unsigned Spins{64};
+        static constexpr std::size_t CacheLine{64};
+
+        template <typename Ready>
+        bool await(Ready&& ready)
+        {
+            for (unsigned i = 0; i < Spins; i++) {
+                if (ready()) return true;
+                std::this_thread::yield();
+            }
+            for (;;) {
+                // the other side bumps the counter after changing the queue, a change
+                // made after this load cannot be missed by the wait below
+                auto seen = mEvents.load(std::memory_order_acquire);
+                if (ready()) return true;
+                if (closed()) return false;
+                mEvents.wait(seen, std::memory_order_acquire);
+            }
+        }
+
+        void signal()
+        {
+            mEvents.fetch_add(1, std::memory_order_release);
+            mEvents.notify_all();
+        }
+
+        std::array<T, Capacity> mSlots{};
+        // written by the consumer
+        alignas(CacheLine) std::atomic<std::size_t> mHead{0};
+        std::size_t mTailCache{0};
+        // written by the producer
+        alignas(CacheLine) std::atomic<std::size_t> mTail{0};
+        std::size_t mHeadCache{0};
+        alignas(CacheLine) std::atomic<unsigned> mEvents{0};
+        std::atomic<bool> mClosed{false};
+    };
+}
@@ -0,0 +1,114 @@
+//
+// Created by Mpho Mbotho on 2021-08-24.
+//
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <tokenizer.hpp>
+
+namespace cyntactic {
+
+    /**
+     * A refillable source of input for the StreamTokenizer
+     */
+    class ChunkSource {
+    public:
+        virtual ~ChunkSource() = default;
+
+        /**
+         * Reads at most \p size bytes into \p buf
+         * @return the number of bytes read, 0 once the input is exhausted
+         */
+        virtual std::size_t read(char *buf, std::size_t size) = 0;
+    };
+
+    /**
+     * Reads chunks from a file descriptor, e.g. a pipe from a code generator
+     */
+    class FdChunkSource : public ChunkSource {
+    public:
+        explicit FdChunkSource(int fd, std::string name = "<fd>")
+            : mFd{fd},
+              mName{std::move(name)}
+        {}
+
+        std::size_t read(char *buf, std::size_t size) override;
+
+    private:
+        int mFd{-1};
+        std::string mName{};
+    };
+
+    /**
+     * Hands out an in-memory string a few bytes at a time
+     */
+    class ViewChunkSource : public ChunkSource {
+    public:
+        ViewChunkSource(std::string_view data, std::size_t chunk)
+            : mData{data},
+              mChunk{chunk}
+        {}
+
+        std::size_t read(char *buf, std::size_t size) override;
+
+    private:
+        std::string_view mData{};
+        std::size_t mChunk{0};
+    };
+
+    /**
+     * Tokenizes input pulled from a ChunkSource through a window that only
+     * grows past the chunk size to hold a token longer than what is left of
+     * the window. It grows geometrically, so memory stays bounded by the
+     * chunk size plus twice the longest token in the input and such a token
+     * is relexed a logarithmic number of times.
+     *
+     * The value of a returned token points into the window and is only valid
+     * until the next call to next().
+     */
+    class StreamTokenizer {
+    public:
+        static constexpr std::size_t DefaultChunk = 64 * 1024;
+
+        StreamTokenizer(ChunkSource& source,
+                        std::string_view name = "<stdin>",
+                        std::size_t chunk = DefaultChunk);
+
+        Token next();
+
+        /**
+         * @return the offset of the last returned token's value in the stream
+         */
+        std::size_t offset() const { return mLast; }
+
+        /**
+         * @return the number of bytes currently reserved for the window
+         */
+        std::size_t capacity() const { return mWindow.size(); }
+
+        /**
+         * @return the number of times the window was refilled, each refill
+         * relexes the token the tokenizer stopped in
+         */
+        std::size_t refills() const { return mRefills; }
+
+    private:
+        void refill(std::size_t keep);
+
+        ChunkSource& mSource;
+        std::string_view mName{};
+        std::size_t mChunk{0};
+        std::vector<char> mWindow{};
+        std::size_t mSize{0};
+        std::size_t mBase{0};
+        std::size_t mLast{0};
+        std::size_t mRefills{0};
+        Tokenizer::Location mOrigin{1, 1};
+        bool mEof{false};
+        Tokenizer mTokenizer{};
+    };
+}
@@ -7,7 +7,9 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <stack>
+#include <vector>
+
+#include <interner.hpp>
 
 namespace cyntactic {
 
@@ -21,32 +23,32 @@ namespace cyntactic {
             S_MODULE
         } Kind;
         Kind kind{};
-        std::string Name{};
+        Interner::Id Name{Interner::None};
     };
 
+    /**
+     * The scopes of a compilation, keyed by the ids of the interner the
+     * compilation's names are interned into. Starts with the global scope.
+     */
     class SymTable {
     public:
-        using Ptr = std::unique_ptr<SymTable>;
+        SymTable();
 
         template <typename T, typename... Args>
-        static bool add(std::string name, Args... args);
-        static bool add(Symbol::Ptr&& sym);
-        static void push();
-        static void pop();
-        static Symbol::Ptr get(const std::string_view& name);
-        static bool isDefined(const std::string_view& name);
+        bool add(Interner::Id name, Args... args);
+        bool add(Symbol::Ptr&& sym);
+        void push();
+        void pop();
+        Symbol::Ptr get(Interner::Id name) const;
+        bool isDefined(Interner::Id name) const;
     private:
-        SymTable(SymTable* parent = nullptr)
-            : mParent{parent}
-        {}
-        static SymTable& get();
-        std::unordered_map<std::string_view, Symbol::Ptr> mSymbols{};
-        SymTable *mParent{nullptr};
+        // innermost last
+        std::vector<std::unordered_map<Interner::Id, Symbol::Ptr>> mScopes{};
     };
 
     template <typename T, typename... Args>
-    bool SymTable::add(std::string name, Args... args)
+    bool SymTable::add(Interner::Id name, Args... args)
     {
-        return add(std::make_unique<T>(std::move(name), std::forward<Args>(args)...));
+        return add(std::make_unique<T>(name, std::forward<Args>(args)...));
     }
-}
\ No newline at end of file
+}
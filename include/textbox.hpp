@@ -9,9 +9,11 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <functional>
 
 namespace cyntactic {
     
@@ -100,13 +102,18 @@ namespace cyntactic {
         std::size_t FindBottomPadding(std::size_t x) const;
     };
 
-    template <typename T>
+    /**
+     * \p Context is handed down from the root to every node rendered, for
+     * what createAtom() needs besides the node
+     */
+    template <typename T, typename Context = std::nullptr_t>
     struct TreeGraph {
         using Iterator = typename T::GraphIt::first_type;
         using GraphIt = typename T::GraphIt;
-        TreeGraph(const T& node, std::size_t maxWidth)
+        TreeGraph(const T& node, std::size_t maxWidth, Context context = {})
             : mNode{node},
-              mMaxWidth{maxWidth}
+              mMaxWidth{maxWidth},
+              mContext{context}
         {}
 
         std::string createAtom() const { return ""; }
@@ -117,8 +124,11 @@ namespace cyntactic {
         const T& getNode(const Iterator& it) const { return *it; }
         TextBox operator()() const;
     private:
+        TextBox compose(std::vector<TextBox>&& boxes) const;
+
         const T& mNode;
         std::size_t mMaxWidth;
+        Context mContext;
     };
 
 /* An utility function that can be used to create a tree graph rendering from a structure.
@@ -184,21 +194,49 @@ namespace cyntactic {
  *                                          and it fits on one line.
  */
 
-    template <typename T>
-    TextBox TreeGraph<T>::operator()() const
+    template <typename T, typename Context>
+    TextBox TreeGraph<T, Context>::operator()() const
+    {
+        // nodes are rendered bottom up from an explicit stack rather than by
+        // recursion, generated code nests deeper than the call stack allows
+        struct Frame {
+            TreeGraph Graph;
+            Iterator Next;
+            Iterator End;
+            std::vector<TextBox> Boxes{};
+        };
+
+        std::vector<Frame> stack;
+        auto [first, last] = countChildren();
+        stack.push_back({*this, first, last});
+        for (;;) {
+            auto& top = stack.back();
+            if (top.Next != top.End) {
+                auto maxWidth = (top.Graph.mMaxWidth >= (16 + 2)) ? top.Graph.mMaxWidth - 2 : 16;
+                TreeGraph child{top.Graph.getNode(top.Next), maxWidth, top.Graph.mContext};
+                ++top.Next;
+                auto [begin, end] = child.countChildren();
+                stack.push_back({child, begin, end});
+                continue;
+            }
+
+            auto box = top.Graph.compose(std::move(top.Boxes));
+            stack.pop_back();
+            if (stack.empty()) {
+                return box;
+            }
+            stack.back().Boxes.push_back(std::move(box));
+        }
+    }
+
+    template <typename T, typename Context>
+    TextBox TreeGraph<T, Context>::compose(std::vector<TextBox>&& boxes) const
     {
         TextBox result;
         auto atom = createAtom();
         result.putline(atom, 0, 0);
 
-        if (auto param_range = countChildren(); param_range.first != param_range.second) {
-            std::vector<TextBox> boxes;
-            boxes.reserve(std::distance(param_range.first, param_range.second));
-            for (auto i = param_range.first; i != param_range.second; ++i) {
-                auto maxWidth = (mMaxWidth >= (16 + 2)) ? mMaxWidth - 2 : 16;
-                boxes.emplace_back(TreeGraph(getNode(i), maxWidth)());
-            }
-
+        if (!boxes.empty()) {
             constexpr std::size_t margin = 4, firstx = 2;
 
             std::size_t sum_width = 0;
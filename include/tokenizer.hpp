@@ -4,9 +4,14 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string_view>
 #include <tuple>
-#include <unordered_map>
+#include <vector>
+
+#include <interner.hpp>
+#include <lines.hpp>
+#include <source.hpp>
 
 namespace cyntactic {
 
@@ -109,79 +114,123 @@ struct Token {
         STR_TYPE,
         BOOL_TYPE,
         CODE_TYPE,
-        FLOAT_TYPE
+        FLOAT_TYPE,
+        ERROR                   // lexical error, only produced when recovering
     } Kind;
+
+    typedef enum {
+        E_NONE,
+        E_UNEXPECTED_CHAR,
+        E_CHAR_ESCAPE,
+        E_UNTERMINATED_CHAR,
+        E_STRING_ESCAPE,
+        E_UNTERMINATED_STRING,
+        E_UNTERMINATED_COMMENT,
+        E_HEX_FLOAT_EXPONENT,
+        E_EXPONENT_DIGITS,
+        E_INVALID_UTF8
+    } Error;
+
     Kind kind{T_EOF};
+    // points into the tokenized code, which also locates the token
     std::string_view Value{};
-    std::string_view Source{};
-    std::size_t Line{0};
-    std::size_t Column{0};
+    // the interned name of IDENTIFIER tokens, the Error code of ERROR tokens
+    // and None for everything else
+    Interner::Id Id{Interner::None};
     void toString(std::ostream& os, bool includeValue = true) const;
+
+    Error error() const { return (kind == ERROR)? Error(Id) : E_NONE; }
+    static std::string_view message(Error error);
 };
 
-static const std::unordered_map<std::string_view, Token::Kind> Keywords{
-    {"if",          Token::IF},
-    {"in",          Token::IN},
-    {"as",          Token::AS},
-    {"for",         Token::FOR},
-    {"auto",        Token::AUTO},
-    {"case",        Token::CASE},
-    {"true",        Token::BOOL_LITERAL},
-    {"break",        Token::BREAK},
-    {"defer",        Token::DEFER},
-    {"false",        Token::BOOL_LITERAL},
-    {"raise",        Token::RAISE},
-    {"else",        Token::ELSE},
-    {"from",        Token::FROM},
-    {"func",        Token::FUNC},
-    {"void",        Token::VOID},
-    {"null",        Token::NONE},
-    {"func",        Token::FUNC},
-    {"this",        Token::THIS},
-    {"using",       Token::USING},
-    {"async",       Token::ASYNC},
-    {"await",       Token::AWAIT},
-    {"while",       Token::WHILE},
-    {"module",      Token::MODULE},
-    {"import",      Token::IMPORT},
-    {"native",      Token::NATIVE},
-    {"switch",      Token::SWITCH},
-    {"return",      Token::RETURN},
-    {"sizeof",      Token::SIZEOF},
-    {"struct",      Token::STRUCT},
-    {"continue",    Token::CONTINUE},
-    {"bool",        Token::BOOL_TYPE},
-    {"short",       Token::INT_TYPE},
-    {"ushort",      Token::INT_TYPE},
-    {"int",         Token::INT_TYPE},
-    {"uint",        Token::INT_TYPE},
-    {"long",        Token::INT_TYPE},
-    {"ulong",       Token::INT_TYPE},
-    {"byte",        Token::INT_TYPE},
-    {"char",        Token::INT_TYPE},
-    {"i8",          Token::INT_TYPE},
-    {"u8",          Token::INT_TYPE},
-    {"i16",         Token::INT_TYPE},
-    {"u16",         Token::INT_TYPE},
-    {"i32",         Token::INT_TYPE},
-    {"u32",         Token::INT_TYPE},
-    {"i64",         Token::INT_TYPE},
-    {"u64",         Token::INT_TYPE},
-    {"f32",         Token::FLOAT_TYPE},
-    {"f64",         Token::FLOAT_TYPE},
-    {"string",      Token::STR_TYPE},
-    {"code",        Token::CODE_TYPE}
+/**
+ * A run of whitespace or a comment recorded on the side when the tokenizer
+ * collects trivia. Next is the index of the significant token it precedes,
+ * Offset and Length are its raw bytes within the tokenized code.
+ */
+struct Trivia {
+    std::uint32_t Next{0};
+    std::uint32_t Offset{0};
+    std::uint32_t Length{0};
+    Token::Kind kind{Token::WHITESPACE};
 };
 
-template <typename T, T T1, T... Ts>
-struct any_of {
-    bool operator()(const T& c) {
-        if (c == T1) return true;
-        if constexpr(sizeof...(Ts) > 0) {
-            return any_of<T, Ts...>{}(c);
-        }
-        return false;
-    }
+/**
+ * A change to the code: Removed bytes at Offset replaced by Inserted
+ */
+struct Edit {
+    std::size_t Offset{0};
+    std::size_t Removed{0};
+    std::string_view Inserted{};
+};
+
+/**
+ * A whole file worth of tokens stored as parallel arrays, 13 bytes per
+ * token. Offsets and lengths describe each token's value within the
+ * tokenized code, the last token is always T_EOF. When trivia is collected
+ * it is kept in Leading, ordered by position.
+ *
+ * After Tokenizer::relex() the tail of Offsets may lag behind by a pending
+ * shift, read offsets through offset() or settle() the buffer first.
+ */
+class TokenBuffer {
+public:
+    TokenBuffer() = default;
+    explicit TokenBuffer(std::string_view code)
+        : mCode{code}
+    {}
+
+    std::size_t size() const { return Kinds.size(); }
+    const std::string_view& code() const { return mCode; }
+    Token::Kind kind(std::size_t i) const { return Token::Kind(Kinds[i]); }
+    std::size_t offset(std::size_t i) const { return std::uint32_t(Offsets[i] + ((i >= mShiftFrom)? mShift : 0)); }
+    std::string_view value(std::size_t i) const { return mCode.substr(offset(i), Lengths[i]); }
+    Token operator[](std::size_t i) const { return {kind(i), value(i), Ids[i]}; }
+
+    /**
+     * @return the offset of the first byte of token \p i, including the
+     * quotes or comment markers left out of its value
+     */
+    std::size_t start(std::size_t i) const;
+
+    /**
+     * @return the offset right after the last byte of token \p i, including
+     * the quotes or comment markers left out of its value
+     */
+    std::size_t end(std::size_t i) const;
+
+    /**
+     * Applies the offset shift still pending from the last relex()
+     */
+    void settle();
+
+    /**
+     * @return the trivia found between token \p i and the token before it
+     */
+    std::pair<const Trivia*, const Trivia*> leading(std::size_t i) const;
+
+    void reserve(std::size_t n);
+    void push(const Token& tok);
+
+    /**
+     * Drops every token and trivia, keeping the code and the capacity
+     */
+    void clear();
+
+    std::vector<std::uint8_t>  Kinds{};
+    std::vector<std::uint32_t> Offsets{};
+    std::vector<std::uint32_t> Lengths{};
+    std::vector<Interner::Id>  Ids{};
+    std::vector<Trivia>        Leading{};
+
+private:
+    friend class Tokenizer;
+    void shift(std::size_t from, std::ptrdiff_t delta);
+
+    std::string_view mCode{};
+    // Offsets from mShiftFrom onwards are short by mShift
+    std::size_t mShiftFrom{0};
+    std::ptrdiff_t mShift{0};
 };
 
 class Tokenizer {
@@ -191,41 +240,172 @@ public:
           mSource{src}
     {}
 
+    /**
+     * Tokenizes a source buffer, the padding of a padded one lets the
+     * tokenizer look ahead without checking for the end of the code
+     */
+    explicit Tokenizer(const SourceBuffer& source)
+        : mCode{source.code()},
+          mSource{source.name()},
+          mPadded{source.padded()}
+    {}
+
     Tokenizer() = default;
 
+    using Location = std::pair<std::size_t, std::size_t>;
+
+    /**
+     * Bytes past the end of a token the tokenizer may look at to decide
+     * where the token ends
+     */
+    static constexpr std::size_t Lookahead{3};
+
+    /**
+     * Strings, comments and character literals are validated as UTF-8 in
+     * blocks of this many bytes ahead of the lexer, code that is never
+     * lexed (say, past an edit being relexed) is not validated
+     */
+    static constexpr std::size_t ValidationBlock{4096};
+
+    typedef enum {
+        TRIVIA_TOKENS,          // whitespace and comments are returned as tokens
+        TRIVIA_COLLECT,         // recorded in a side table, see collected()
+        TRIVIA_SKIP             // dropped
+    } TriviaMode;
+
     void reset(std::string_view code, const std::string_view& src = "<stdin>");
+    void reset(const SourceBuffer& source);
+
+    /**
+     * Resets the tokenizer to a window of a larger input, \p origin being the
+     * line and column of the window's first byte within that input
+     */
+    void reset(std::string_view code, const std::string_view& src, Location origin);
     const std::string_view& source() const { return mSource; }
-    std::size_t line() const { return mLine; }
-    std::size_t column() const { return mCol; }
+
+    /**
+     * Interns the name of every IDENTIFIER token produced from here on into
+     * \p names, tokens carry no name id while no interner is attached
+     */
+    void intern(Interner *names) { mNames = names; }
+
+    /**
+     * When enabled, a lexical error produces an ERROR token carrying its
+     * Token::Error code instead of throwing a SyntaxError. Lexing resumes
+     * right after the offending byte, or after the closing quote of a
+     * broken literal when it is on the same line. A token containing ill
+     * formed UTF-8 is replaced by an ERROR token spanning all of it.
+     */
+    void recover(bool enabled) { mRecover = enabled; }
+
+    /**
+     * Unless trivia is returned as tokens, next() only ever returns
+     * significant tokens
+     */
+    void trivia(TriviaMode mode) { mTriviaMode = mode; }
+
+    /**
+     * @return the trivia collected by next() since the last reset, each
+     * tagged with the number of significant tokens returned before it
+     */
+    const std::vector<Trivia>& collected() const { return mCollected; }
+    std::size_t offset() const { return mPos; }
+    std::size_t line() const { return location(mPos).first; }
+    std::size_t column() const { return location(mPos).second; }
+
+    /**
+     * @return the line and column of the given byte offset, the line index
+     * is only built the first time a location is needed
+     */
+    Location location(std::size_t offset) const;
 
     Token next();
 
+    /**
+     * Continues lexing at \p offset, which must be where a token or trivia starts
+     */
+    void seek(std::size_t offset) { mPos = offset; }
+
+    /**
+     * Moves past the '}' matching the '{' next() just returned, without
+     * lexing the code in between. Braces in string and character literals
+     * and in comments do not count.
+     * @return false, leaving the position as it was, if the code ends first
+     */
+    bool skipBody();
+
+    /**
+     * Tokenizes everything from the current position up to and including the
+     * final T_EOF token, collected trivia is moved into the buffer
+     */
+    TokenBuffer tokenizeAll();
+
+    /**
+     * Same as tokenizeAll(), but splits the input into \p threads chunks that
+     * are lexed concurrently, each speculatively starting at a line start.
+     * Chunks whose speculation does not line up with the tokens of the chunk
+     * before them are lexed again, the result is identical to tokenizeAll().
+     */
+    TokenBuffer tokenizeAll(unsigned threads);
+
+    /**
+     * Updates \p tokens, lexed from the code before \p edit, to match the
+     * edited \p code. Lexing restarts at the last token boundary the edit
+     * cannot affect and stops as soon as a token starts where an old one did,
+     * the offsets of the remaining tokens are shifted lazily. The tokenizer
+     * must be configured as it was when \p tokens was produced, collected
+     * trivia past the edit is shifted eagerly.
+     * @return the range of tokens that were lexed again
+     */
+    std::pair<std::size_t, std::size_t> relex(TokenBuffer& tokens, std::string_view code, const Edit& edit);
+
 private cynt_ut:
-    char peek() const;
-    std::pair<char, char> peekTwo() const;
-    std::tuple<char, char, char> peekThree() const;
+    // Padded instances read past the end of the code without checking
+    template <bool Padded> Token token();
+    template <bool Padded> char peek() const;
+    template <bool Padded> std::pair<char, char> peekTwo() const;
+    template <bool Padded> std::tuple<char, char, char> peekThree() const;
 
-    Token tok(Token&& tok, unsigned c = 1);
-    void eat(unsigned c = 1);
+    template <bool Padded> Token tok(Token&& tok, unsigned c = 1);
+    template <bool Padded> void eat(unsigned c = 1);
+    void skip(const char *to);
     void eatWhiteSpace();
 
-    Token parseString();
-    Token parseHexFloat(std::size_t start) { return {}; }
-    Token parseHexNumber();
-    Token parseCharacter();
+    template <bool Padded> Token parseString();
+    template <bool Padded> Token parseHexFloat(std::size_t start);
+    template <bool Padded> Token parseHexNumber();
+    template <bool Padded> Token parseCharacter();
     Token parseIdentifier();
-    Token parseOctalNumber();
-    Token parseBinaryNumber();
-    Token parseDecimalFloat(std::size_t start) { return {}; }
-    Token parseDecimalNumber();
-    Token parseMultiLineComment();
+    Token parseUnicode();
+    template <bool Padded> Token parseOctalNumber();
+    template <bool Padded> Token parseBinaryNumber();
+    template <bool Padded> Token parseDecimalFloat(std::size_t start);
+    template <bool Padded> bool parseExponent();
+    // error paths stay out of line, they would only weigh on the lexer's inlining
+    template <typename... Args>
+    [[gnu::cold]] Token fail(Token::Error error, std::size_t start, char until, Args&&... args);
+    template <bool Padded> Token parseDecimalNumber();
+    template <bool Padded> Token parseMultiLineComment();
     Token parseSingleLineComment();
+    Token text(std::size_t start, Token&& tok);
+    Token validate(std::size_t start, Token&& tok);
+
+    struct Chunk;
+    void tokenizeRange(Chunk& chunk, std::size_t from, std::size_t until);
 
     std::string_view mCode{};
     std::string_view mSource{};
+    bool mPadded{false};
     std::size_t  mPos{0};
-    std::size_t mLine{1};
-    std::size_t mCol{1};
+    // the code between the last validated token and here is well formed UTF-8
+    std::size_t  mValid{0};
+    mutable LineIndex mLines{};
+    Location mOrigin{1, 1};
+    Interner *mNames{nullptr};
+    bool mRecover{false};
+    TriviaMode mTriviaMode{TRIVIA_TOKENS};
+    std::vector<Trivia> mCollected{};
+    std::size_t mSignificant{0};
 };
 
 }
\ No newline at end of file
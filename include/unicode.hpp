@@ -0,0 +1,61 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cyntactic::utf8 {
+
+    /**
+     * @return the length of the well formed UTF-8 sequence starting at \p p,
+     * or 0 if the bytes in [p, end) do not start one (stray continuation
+     * bytes, overlong forms, surrogates, code points above U+10FFFF and
+     * sequences cut short by \p end)
+     */
+    inline unsigned sequence(const char *p, const char *end)
+    {
+        auto at = [&](std::size_t i) { return std::uint8_t(p[i]); };
+        auto cont = [&](std::size_t i, std::uint8_t lo = 0x80, std::uint8_t hi = 0xBF) {
+            return p + i < end && at(i) >= lo && at(i) <= hi;
+        };
+
+        auto c = at(0);
+        if (c < 0x80) return 1;
+        if (c < 0xC2) return 0;
+        if (c < 0xE0) return cont(1)? 2 : 0;
+        if (c < 0xF0) {
+            auto ok = (c == 0xE0)? cont(1, 0xA0) : (c == 0xED)? cont(1, 0x80, 0x9F) : cont(1);
+            return (ok && cont(2))? 3 : 0;
+        }
+        if (c < 0xF5) {
+            auto ok = (c == 0xF0)? cont(1, 0x90) : (c == 0xF4)? cont(1, 0x80, 0x8F) : cont(1);
+            return (ok && cont(2) && cont(3))? 4 : 0;
+        }
+        return 0;
+    }
+
+    /**
+     * Decodes the well formed sequence of \p length bytes at \p p
+     */
+    inline char32_t decode(const char *p, unsigned length)
+    {
+        auto at = [&](std::size_t i) { return char32_t(std::uint8_t(p[i])); };
+        switch (length) {
+            case 1: return at(0);
+            case 2: return ((at(0) & 0x1F) << 6) | (at(1) & 0x3F);
+            case 3: return ((at(0) & 0x0F) << 12) | ((at(1) & 0x3F) << 6) | (at(2) & 0x3F);
+            default:
+                return ((at(0) & 0x07) << 18) | ((at(1) & 0x3F) << 12) | ((at(2) & 0x3F) << 6) | (at(3) & 0x3F);
+        }
+    }
+
+    /**
+     * Unicode identifier properties (UAX #31) of code points above U+007F,
+     * ASCII is classified by the tokenizer's own tables
+     */
+    bool isXidStart(char32_t c);
+    bool isXidContinue(char32_t c);
+}
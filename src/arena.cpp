@@ -0,0 +1,68 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "arena.hpp"
+
+#include <cstring>
+
+namespace cyntactic {
+
+    void* Arena::grow(std::size_t size, std::size_t align)
+    {
+        auto aligned = [](char *p, std::size_t align) {
+            return p + (std::size_t(-reinterpret_cast<std::uintptr_t>(p)) & (align - 1));
+        };
+
+        if (size > BlockSize / 4) {
+            // large requests get a block of their own, the current one keeps serving small ones
+            mBlocks.push_back(std::make_unique<char[]>(size + align));
+            return aligned(mBlocks.back().get(), align);
+        }
+
+        mBlocks.push_back(std::make_unique<char[]>(BlockSize));
+        mCursor = mBlocks.back().get();
+        mAvailable = BlockSize;
+        return allocate(size, align);
+    }
+
+    std::string_view Arena::copy(std::string_view text)
+    {
+        auto *p = static_cast<char*>(allocate(text.size(), 1));
+        memcpy(p, text.data(), text.size());
+        return {p, text.size()};
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+#include <string>
+
+TEST_CASE("Arena allocations are aligned and never move", "[arena]")
+{
+    cyntactic::Arena arena;
+    CHECK(arena.blocks() == 0);
+
+    std::vector<std::pair<std::string_view, std::string>> copies;
+    for (unsigned i = 0; i < 20000; i++) {
+        auto text = "text_" + std::to_string(i);
+        copies.emplace_back(arena.copy(text), text);
+        auto *p = arena.allocate(8, 8);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 8 == 0);
+        memset(p, 0xAB, 8);
+    }
+    // a large request in the middle of a block leaves the block in use
+    auto blocks = arena.blocks();
+    auto *big = static_cast<char*>(arena.allocate(cyntactic::Arena::BlockSize, 64));
+    CHECK(reinterpret_cast<std::uintptr_t>(big) % 64 == 0);
+    memset(big, 0xCD, cyntactic::Arena::BlockSize);
+    CHECK(arena.blocks() == blocks + 1);
+    copies.emplace_back(arena.copy("after"), "after");
+    CHECK(arena.blocks() == blocks + 1);
+
+    for (const auto& [copy, text]: copies) {
+        REQUIRE(copy == text);
+    }
+}
+#endif
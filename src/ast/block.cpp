@@ -0,0 +1,23 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "ast/block.hpp"
+#include "parser.hpp"
+
+namespace cyntactic::ast {
+
+    const NodeList& Block::body() const
+    {
+        if (lazy()) {
+            // parsing the body only changes when it is parsed, not what it is
+            Parser parser;
+            parser.expand(const_cast<Block&>(*this));
+        }
+        return Children;
+    }
+
+    std::string Block::toString(bool compressed, const Interner *names) const {
+        return lazy()? "{...}" : "{}";
+    }
+}
@@ -0,0 +1,12 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "ast/error.hpp"
+
+namespace cyntactic::ast {
+
+    std::string Error::toString(bool compressed, const Interner *names) const {
+        return "<error>";
+    }
+}
@@ -6,7 +6,7 @@
 
 namespace cyntactic::ast {
 
-    std::string Identifier::toString(bool compressed) const {
-        return Name;
+    std::string Identifier::toString(bool compressed, const Interner *names) const {
+        return names? std::string{names->str(Name)} : "#" + std::to_string(Name);
     }
 }
\ No newline at end of file
@@ -7,16 +7,25 @@
 
 namespace cyntactic::ast {
 
-    std::string Import::toString(bool compressed) const
+    std::string Import::toString(bool compressed, const Interner *names) const
     {
+        return Import::str(names, Name, Symbols, Alias, compressed);
+    }
+
+    std::string Import::str(const Interner *names, Interner::Id name, std::span<const Interner::Id> symbols,
+                            Interner::Id alias, bool compressed)
+    {
+        auto text = [names](Interner::Id id) {
+            return names? std::string{names->str(id)} : "#" + std::to_string(id);
+        };
         std::stringstream ss;
-        ss << "Import (" << Name;
-        if (!Symbols.empty()) {
+        ss << "Import (" << text(name);
+        if (!symbols.empty()) {
             if (!compressed) {
                 ss << "/{";
-                for (const auto& sym: Symbols) {
-                    if (&sym != &Symbols[0]) ss << ", ";
-                    ss << sym;
+                for (const auto& sym: symbols) {
+                    if (&sym != &symbols[0]) ss << ", ";
+                    ss << text(sym);
                 }
                 ss << "}";
             }
@@ -24,8 +33,8 @@ namespace cyntactic::ast {
                 ss << "{...}";
             }
         }
-        if (!Alias.empty()) {
-            ss << " as " << Alias;
+        if (alias != Interner::None) {
+            ss << " as " << text(alias);
         }
         ss << ")";
         return ss.str();
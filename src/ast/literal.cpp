@@ -7,7 +7,12 @@
 
 namespace cyntactic::ast {
 
-    std::string Literal::toString(bool compressed) const
+    std::string Literal::toString(bool compressed, const Interner *names) const
+    {
+        return Literal::str(mValue);
+    }
+
+    std::string Literal::str(const Variant& value)
     {
         std::string str{""};
         std::visit([&](const auto& v) {
@@ -30,7 +35,7 @@ namespace cyntactic::ast {
             else {
                 str = v;
             }
-        }, mValue);
+        }, value);
 
         return str;
     }
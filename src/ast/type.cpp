@@ -40,7 +40,7 @@ namespace cyntactic::ast {
         return it->second;
     }
 
-    std::string NumberType::toString(bool compressed) const
+    std::string NumberType::toString(bool compressed, const Interner *names) const
     {
         return std::string{mName};
     }
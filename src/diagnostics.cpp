@@ -0,0 +1,156 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "diagnostics.hpp"
+
+#include <sstream>
+
+namespace cyntactic {
+
+    std::string_view Diagnostic::format(Code code)
+    {
+        switch (code) {
+            case D_LEXICAL: return "{0}";
+            case D_UNEXPECTED_CHAR: return "unexpected character '{0}'";
+            case D_EXPECTING_PRIMARY: return "unexpected token, expecting primary-expression";
+            case D_EXPECTING_OPERATOR: return "unexpected token, expecting binary operator";
+            case D_EXPECTING_SEMICOLON: return "expression's missing terminal semi-colon ';'";
+            case D_EXPECTING_IDENTIFIER: return "unexpected token, expecting identifier";
+            case D_EXPECTING_IMPORT: return "unexpected token, expecting 'import'";
+            case D_EXPECTING_MODULE: return "invalid import statement, expecting name of module";
+            case D_EXPECTING_SYMBOLS: return "unexpected token, expecting '{' or symbol name";
+            case D_EXPECTING_SYMBOLS_END: return "unexpected token, expecting '}' to import symbols";
+            case D_EXPECTING_ALIAS: return "unexpected token, expecting the name of the symbol ";
+            case D_IMPORT_TERMINATOR: return "import statement must be terminated by a ';'";
+            case D_EXPECTING_BLOCK_END: return "unexpected token, expecting '}' to close the block";
+            case D_UNDEFINED_VARIABLE: return "variable '{0}' not defined";
+            case D_INTEGER_RANGE: return "integer literal '{0}' does not fit in 64 bits";
+            case D_INTEGER_INVALID: return "invalid integer literal '{0}'";
+            case D_FLOAT_RANGE: return "floating point literal '{0}' is out of range";
+            case D_FLOAT_INVALID: return "invalid floating point literal '{0}'";
+            default: return "unknown diagnostic";
+        }
+    }
+
+    void Diagnostic::message(std::ostream& os) const
+    {
+        auto fmt = format(code);
+        std::size_t i{0};
+        while (i < fmt.size()) {
+            // only {N} with a single digit is a placeholder, any other brace is text
+            if (fmt[i] == '{' && i + 2 < fmt.size() && fmt[i + 2] == '}' &&
+                fmt[i + 1] >= '0' && fmt[i + 1] < char('0' + MaxArgs))
+            {
+                std::visit([&os](const auto& arg) {
+                    if constexpr (!std::is_same_v<std::decay_t<decltype(arg)>, std::monostate>) {
+                        os << arg;
+                    }
+                }, Args[fmt[i + 1] - '0']);
+                i += 3;
+                continue;
+            }
+            os << fmt[i++];
+        }
+    }
+
+    bool DiagnosticEngine::admit(Diagnostic::Severity severity, Diagnostic::Code code, SourceLoc loc)
+    {
+        if (severity < mMinimum) {
+            return false;
+        }
+        for (auto it = mDiagnostics.rbegin(); it != mDiagnostics.rend() && it->Loc.Raw >= loc.Raw; it++) {
+            if (it->Loc.Raw == loc.Raw && it->code == code) {
+                return false;
+            }
+        }
+        if (severity == Diagnostic::ERROR && mErrors++ >= mLimit && mLimit != 0) {
+            return false;
+        }
+        return true;
+    }
+
+    void DiagnosticEngine::clear()
+    {
+        mDiagnostics.clear();
+        mErrors = 0;
+    }
+
+    void DiagnosticEngine::render(std::ostream& os, const Diagnostic& diag, const SourceManager& sources)
+    {
+        auto [file, line, column] = sources.decode(diag.Loc);
+        os << file << ":" << line << ":" << column
+           << ((diag.severity == Diagnostic::ERROR)? ": error(syntax): " : ": warning(syntax): ");
+        diag.message(os);
+    }
+
+    std::string DiagnosticEngine::render(const Diagnostic& diag, const SourceManager& sources)
+    {
+        std::stringstream ss;
+        render(ss, diag, sources);
+        return ss.str();
+    }
+
+    void DiagnosticEngine::print(std::ostream& os, const SourceManager& sources) const
+    {
+        for (const auto& diag: mDiagnostics) {
+            render(os, diag, sources);
+            os << '\n';
+        }
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("Diagnostics are rendered only when printed", "[diagnostics]")
+{
+    using namespace cyntactic;
+    SourceManager sources;
+    auto base = sources.add(SourceBuffer::copy("x = 0xFFFFFFFFFFFFFFFFF;\ny;", "<test>"));
+    DiagnosticEngine diags;
+    std::string_view code{"0xFFFFFFFFFFFFFFFFF"};
+    CHECK(diags.report(Diagnostic::ERROR, Diagnostic::D_INTEGER_RANGE, base + 4, code));
+    CHECK(diags.report(Diagnostic::WARNING, Diagnostic::D_UNEXPECTED_CHAR, base + 25, 'y'));
+    CHECK(diags.report(Diagnostic::ERROR, Diagnostic::D_EXPECTING_SYMBOLS, base + 26));
+    REQUIRE(diags.size() == 3);
+    CHECK(diags.errors() == 2);
+
+    std::stringstream ss;
+    diags.print(ss, sources);
+    CHECK(ss.str() ==
+          "<test>:1:5: error(syntax): integer literal '0xFFFFFFFFFFFFFFFFF' does not fit in 64 bits\n"
+          "<test>:2:1: warning(syntax): unexpected character 'y'\n"
+          // braces that are not placeholders are kept
+          "<test>:2:2: error(syntax): unexpected token, expecting '{' or symbol name\n");
+    CHECK(DiagnosticEngine::render(diags[0], sources) ==
+          "<test>:1:5: error(syntax): integer literal '0xFFFFFFFFFFFFFFFFF' does not fit in 64 bits");
+}
+
+TEST_CASE("Diagnostics are filtered, deduplicated and capped", "[diagnostics]")
+{
+    using namespace cyntactic;
+    SourceLoc loc{1};
+    DiagnosticEngine diags;
+    diags.filter(Diagnostic::ERROR);
+    diags.limit(3);
+    CHECK_FALSE(diags.report(Diagnostic::WARNING, Diagnostic::D_EXPECTING_PRIMARY, loc));
+    CHECK(diags.report(Diagnostic::ERROR, Diagnostic::D_EXPECTING_PRIMARY, loc));
+    // the same problem at the same place is reported once
+    CHECK_FALSE(diags.report(Diagnostic::ERROR, Diagnostic::D_EXPECTING_PRIMARY, loc));
+    CHECK(diags.report(Diagnostic::ERROR, Diagnostic::D_EXPECTING_OPERATOR, loc));
+    // even when reported out of order
+    CHECK(diags.report(Diagnostic::ERROR, Diagnostic::D_EXPECTING_PRIMARY, loc + 1));
+    CHECK_FALSE(diags.report(Diagnostic::ERROR, Diagnostic::D_EXPECTING_OPERATOR, loc));
+    CHECK(diags.full());
+    CHECK_FALSE(diags.report(Diagnostic::ERROR, Diagnostic::D_EXPECTING_PRIMARY, loc + 2));
+    CHECK(diags.size() == 3);
+    CHECK(diags.errors() == 4);
+
+    diags.clear();
+    CHECK(diags.empty());
+    CHECK_FALSE(diags.full());
+    // the filter outlives clear()
+    CHECK_FALSE(diags.report(Diagnostic::WARNING, Diagnostic::D_EXPECTING_PRIMARY, loc));
+}
+#endif
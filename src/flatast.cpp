@@ -0,0 +1,222 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "flatast.hpp"
+#include "ast/block.hpp"
+#include "ast/identifier.hpp"
+#include "ast/import.hpp"
+#include "ast/type.hpp"
+
+namespace cyntactic {
+
+    FlatAst FlatAst::flatten(const Program& pg)
+    {
+        FlatAst flat;
+        flat.Buffer = pg.Buffer;
+        flat.Sources = pg.Sources;
+        flat.Names = pg.Names;
+        flat.Strings = pg.Strings;
+
+        // the nodes in id order, which is the order they are visited in
+        std::vector<const Node*> nodes{&pg};
+        if (pg.Nodes) {
+            nodes.reserve(pg.Nodes->nodes() + 1);
+            auto n = nodes.capacity();
+            flat.Tags.reserve(n);
+            flat.First.reserve(n);
+            flat.Counts.reserve(n);
+            flat.Locs.reserve(n);
+            flat.Payloads.reserve(n);
+        }
+
+        for (NodeId id = 0; id < nodes.size(); id++) {
+            const auto& node = *nodes[id];
+            // the body of a block skipped by a lazy parse is parsed here
+            const auto& children = (node.Tag == Node::BLOCK)?
+                    static_cast<const ast::Block&>(node).body() : node.Children;
+            flat.Tags.push_back(std::uint8_t(node.Tag));
+            flat.First.push_back(NodeId(nodes.size()));
+            flat.Counts.push_back(std::uint32_t(children.size()));
+            flat.Locs.push_back(node.Loc);
+            nodes.insert(nodes.end(), children.begin(), children.end());
+
+            auto payload = None;
+            switch (node.Tag) {
+                case Node::IDENT:
+                    payload = std::uint32_t(flat.Identifiers.size());
+                    flat.Identifiers.push_back(static_cast<const ast::Identifier&>(node).Name);
+                    break;
+                case Node::NUMBER_TYPE:
+                    payload = std::uint32_t(flat.Types.size());
+                    flat.Types.push_back(static_cast<const ast::NumberType&>(node).name());
+                    break;
+                case Node::LITERAL:
+                    payload = std::uint32_t(flat.Literals.size());
+                    flat.Literals.push_back(static_cast<const ast::Literal&>(node).value());
+                    break;
+                case Node::IMPORT: {
+                    const auto& import = static_cast<const ast::Import&>(node);
+                    payload = std::uint32_t(flat.Imports.size());
+                    flat.Imports.push_back({import.Name, import.Alias,
+                                            std::uint32_t(flat.Identifiers.size()),
+                                            std::uint32_t(import.Symbols.size())});
+                    flat.Identifiers.insert(flat.Identifiers.end(), import.Symbols.begin(), import.Symbols.end());
+                    break;
+                }
+                case Node::BINARY_EXPR:
+                    payload = std::uint32_t(static_cast<const ast::BinaryExpr&>(node).Op.Op);
+                    break;
+                default:
+                    break;
+            }
+            flat.Payloads.push_back(payload);
+        }
+        return flat;
+    }
+
+    std::string_view FlatAst::name(NodeId id) const
+    {
+        if (tag(id) == Node::NUMBER_TYPE) {
+            return Types[Payloads[id]];
+        }
+        return Names->str(Identifiers[Payloads[id]]);
+    }
+
+    std::string FlatAst::str(NodeId id, bool compressed) const
+    {
+        switch (tag(id)) {
+            case Node::PROGRAM:
+                return "Program";
+            case Node::IDENT:
+            case Node::NUMBER_TYPE:
+                return std::string{name(id)};
+            case Node::LITERAL:
+                return ast::Literal::str(literal(id));
+            case Node::IMPORT: {
+                const auto& import = this->import(id);
+                std::span<const Interner::Id> symbols{Identifiers.data() + import.First, import.Count};
+                return ast::Import::str(Names.get(), import.Name, symbols, import.Alias, compressed);
+            }
+            case Node::BINARY_EXPR:
+                return std::string{op(id).Str};
+            case Node::BLOCK:
+                return "{}";
+            case Node::ERROR:
+                return "<error>";
+            default:
+                return "";
+        }
+    }
+
+    void FlatAst::dump(std::ostream& os) const
+    {
+        if (Tags.empty()) {
+            return;
+        }
+        std::vector<std::pair<NodeId, unsigned>> stack{{Root, 0}};
+        while (!stack.empty()) {
+            auto [id, depth] = stack.back();
+            stack.pop_back();
+            os << std::string(depth * 2, ' ') << str(id) << '\n';
+            // pushed last to first so that they are printed in order
+            for (auto child = First[id] + Counts[id]; child-- > First[id];) {
+                stack.emplace_back(child, depth + 1);
+            }
+        }
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+#include <sstream>
+
+#include "parser.hpp"
+
+TEST_CASE("Flat AST mirrors the program's tree", "[flatast]")
+{
+    using namespace cyntactic;
+    Parser parser;
+    std::string_view code{"import io.{print, read} -> sys;\n1 + 2 * 3;\n\"text\";\n"};
+    auto pg = parser.parse(code, "<test>");
+    auto flat = FlatAst::flatten(pg);
+
+    REQUIRE(flat.size() == pg.Nodes->nodes() + 1);
+    CHECK(flat.tag(FlatAst::Root) == Node::PROGRAM);
+    auto [first, last] = flat.children(FlatAst::Root);
+    REQUIRE(last - first == 3);
+    CHECK(flat.tag(first) == Node::IMPORT);
+    CHECK(flat.tag(first + 1) == Node::BINARY_EXPR);
+    CHECK(flat.tag(first + 2) == Node::LITERAL);
+
+    const auto& import = flat.import(first);
+    CHECK(flat.Names->str(import.Name) == "io");
+    CHECK(flat.Names->str(import.Alias) == "sys");
+    REQUIRE(import.Count == 2);
+    CHECK(flat.Names->str(flat.Identifiers[import.First + 1]) == "read");
+    CHECK(flat.str(first, false) == "Import (io/{print, read} as sys)");
+
+    // 1 + (2 * 3)
+    auto sum = first + 1;
+    CHECK(flat.op(sum).Op == ast::BinaryOp::OP_ADD);
+    auto offset = [&](NodeId id) { return flat.Sources->find(flat.loc(id)).second; };
+    CHECK(offset(sum) == code.find('1'));
+    auto [lhs, rhs] = flat.children(sum);
+    REQUIRE(rhs - lhs == 2);
+    CHECK(std::get<std::uint64_t>(flat.literal(lhs)) == 1);
+    CHECK(flat.op(lhs + 1).Op == ast::BinaryOp::OP_MUL);
+    CHECK(offset(lhs + 1) == code.find('2'));
+    CHECK(flat.str(first + 2) == "text");
+    CHECK(offset(first + 2) == code.find("text"));
+    CHECK(pg.location(*pg.Children.back()).Line == 3);
+
+    std::stringstream ss;
+    flat.dump(ss);
+    CHECK(ss.str() == "Program\n"
+                      "  Import (io{...} as sys)\n"
+                      "  +\n"
+                      "    1\n"
+                      "    *\n"
+                      "      2\n"
+                      "      3\n"
+                      "  text\n");
+
+    // nothing points back into the program's nodes
+    auto copy = flat;
+    pg = Program{};
+    std::stringstream again;
+    copy.dump(again);
+    CHECK(again.str() == ss.str());
+}
+
+TEST_CASE("Flattening a lazily parsed program parses the skipped bodies", "[flatast]")
+{
+    using namespace cyntactic;
+    std::string_view code{"{ 1 + 2; { 3; } }\n4;\n{}\n"};
+    auto dump = [](const FlatAst& flat) {
+        std::stringstream ss;
+        flat.dump(ss);
+        return ss.str();
+    };
+    Parser parser;
+    auto eager = parser.parse(code, "<test>");
+    parser.lazy(true);
+    auto pg = parser.parse(code, "<test>");
+    REQUIRE(static_cast<const ast::Block&>(*pg.Children.front()).lazy());
+
+    auto flat = FlatAst::flatten(pg);
+    CHECK(dump(flat) == dump(FlatAst::flatten(eager)));
+    CHECK(flat.size() == pg.Nodes->nodes() + 1);
+    CHECK(flat.str(flat.children(FlatAst::Root).first) == pg.Children.front()->toString());
+    CHECK(dump(flat) == "Program\n"
+                        "  {}\n"
+                        "    +\n"
+                        "      1\n"
+                        "      2\n"
+                        "    {}\n"
+                        "      3\n"
+                        "  4\n"
+                        "  {}\n");
+}
+#endif
@@ -0,0 +1,127 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "interner.hpp"
+
+#include <cstring>
+
+namespace {
+    constexpr std::size_t InitialSlots = 1024;
+}
+
+namespace cyntactic {
+
+    Interner::Interner()
+        : mNames{""},
+          mHashes{0},
+          mSlots(InitialSlots, None)
+    {}
+
+    std::uint64_t Interner::hash(std::string_view name)
+    {
+        // FNV-1a over 8 byte words, names are short and this keeps it cheap.
+        // A multiply only carries a byte of a word upwards, so the result
+        // is mixed down again before slots are taken from its low bits.
+        std::uint64_t h{0xcbf29ce484222325ull};
+        const char *p = name.data();
+        auto n = name.size();
+        for (; n >= 8; p += 8, n -= 8) {
+            std::uint64_t word;
+            memcpy(&word, p, 8);
+            h = (h ^ word) * 0x100000001b3ull;
+        }
+        for (; n > 0; p++, n--) {
+            h = (h ^ std::uint8_t(*p)) * 0x100000001b3ull;
+        }
+        // murmur3's fmix64
+        h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdull;
+        h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ull;
+        return h ^ (h >> 33);
+    }
+
+    Interner::Id Interner::find(std::string_view name) const
+    {
+        auto h = std::uint32_t(hash(name));
+        auto mask = mSlots.size() - 1;
+        for (auto i = h & mask;; i = (i + 1) & mask) {
+            auto id = mSlots[i];
+            if (id == None) return None;
+            if (mHashes[id] == h && mNames[id] == name) return id;
+        }
+    }
+
+    Interner::Id Interner::intern(std::string_view name)
+    {
+        auto h = std::uint32_t(hash(name));
+        auto mask = mSlots.size() - 1;
+        auto i = h & mask;
+        for (;; i = (i + 1) & mask) {
+            auto id = mSlots[i];
+            if (id == None) break;
+            if (mHashes[id] == h && mNames[id] == name) return id;
+        }
+
+        auto id = Id(mNames.size());
+        mNames.push_back(mStorage.copy(name));
+        mHashes.push_back(h);
+        mSlots[i] = id;
+        // keep the table at most half full
+        if (mNames.size() * 2 > mSlots.size()) {
+            grow();
+        }
+        return id;
+    }
+
+    void Interner::grow()
+    {
+        std::vector<Id> slots(mSlots.size() * 2, None);
+        auto mask = slots.size() - 1;
+        for (Id id = 1; id < mNames.size(); id++) {
+            auto i = mHashes[id] & mask;
+            while (slots[i] != None) i = (i + 1) & mask;
+            slots[i] = id;
+        }
+        mSlots = std::move(slots);
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+#include <string>
+
+TEST_CASE("Interner hands out one dense id per distinct name", "[interner]")
+{
+    cyntactic::Interner names;
+    std::vector<std::string> words;
+    for (unsigned i = 0; i < 5000; i++) {
+        words.push_back("name_" + std::to_string(i));
+    }
+    for (std::size_t i = 0; i < words.size(); i++) {
+        REQUIRE(names.intern(words[i]) == i + 1);
+    }
+    for (std::size_t i = 0; i < words.size(); i++) {
+        REQUIRE(names.intern(std::string{words[i]}) == i + 1);
+        REQUIRE(names.str(cyntactic::Interner::Id(i + 1)) == words[i]);
+    }
+    CHECK(names.size() == words.size());
+    CHECK(names.find("not_interned") == cyntactic::Interner::None);
+}
+
+TEST_CASE("Names differing only in their last bytes spread over the slots", "[interner]")
+{
+    // the last bytes of an 8 byte word, e.g. var00001, var00002...
+    constexpr std::size_t Slots = 4096;
+    std::vector<bool> used(Slots);
+    std::size_t distinct{0};
+    for (unsigned i = 0; i < Slots; i++) {
+        auto name = "var" + std::to_string(100000 + i).substr(1);
+        auto slot = cyntactic::Interner::hash(name) & (Slots - 1);
+        distinct += !used[slot];
+        used[slot] = true;
+    }
+    // a random spread fills about 63% of the slots
+    CHECK(distinct > Slots / 2);
+}
+#endif
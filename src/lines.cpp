@@ -0,0 +1,44 @@
+//
+// Created by Mpho Mbotho on 2021-08-23.
+//
+
+#include "lines.hpp"
+#include "scanner.hpp"
+
+#include <algorithm>
+
+namespace cyntactic {
+
+    LineIndex::LineIndex(std::string_view code)
+    {
+        // one pass collecting every newline, each of which starts the next line
+        mStarts.reserve(code.size() / 32 + 1);
+        mStarts.push_back(0);
+        scan::collect(code.data(), code.data() + code.size(), '\n', mStarts);
+        for (std::size_t i = 1; i < mStarts.size(); i++) {
+            mStarts[i] += 1;
+        }
+    }
+
+    std::pair<std::size_t, std::size_t> LineIndex::location(std::size_t offset) const
+    {
+        auto it = std::upper_bound(mStarts.begin(), mStarts.end(), offset);
+        auto line = std::size_t(it - mStarts.begin());
+        return {line, offset - *(it - 1) + 1};
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("LineIndex maps offsets to 1-based lines and columns", "[lines]")
+{
+    cyntactic::LineIndex index{"ab\n\ncd\n"};
+    CHECK(index.lines() == 4);
+    CHECK(index.location(0) == std::make_pair(1ul, 1ul));
+    CHECK(index.location(2) == std::make_pair(1ul, 3ul));
+    CHECK(index.location(3) == std::make_pair(2ul, 1ul));
+    CHECK(index.location(5) == std::make_pair(3ul, 2ul));
+    CHECK(index.location(7) == std::make_pair(4ul, 1ul));
+}
+#endif
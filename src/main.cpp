@@ -16,7 +16,11 @@ R"(
 6 + one;
 )";
     Parser p;
-    auto pg = p.parse(Source, "<stdin>");
+    p.recover(true);
+    auto pg = (argc > 1)?
+            p.parse(std::filesystem::path{argv[1]}) :
+            p.parse(Source, "<stdin>");
+    p.diagnostics().print(std::cerr, *pg.Sources);
     pg.dump(std::cout);
-    return 0;
+    return (p.diagnostics().errors() == 0)? 0 : 1;
 }
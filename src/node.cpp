@@ -5,21 +5,91 @@
 #include "node.hpp"
 #include "trie.hpp"
 
+#include <algorithm>
+
+#include <cstring>
+
 namespace cyntactic {
 
+    AstArena::~AstArena()
+    {
+        for (auto it = mFinalizers.rbegin(); it != mFinalizers.rend(); it++) {
+            it->Destroy(it->Object);
+        }
+    }
+
+    void NodeList::grow(AstArena& arena)
+    {
+        auto capacity = std::max<std::uint32_t>(mCapacity * 2, 8);
+        auto *items = static_cast<Node**>(arena.allocate(capacity * sizeof(Node*), alignof(Node*)));
+        // the old array is left to the arena, it is released with everything else
+        memcpy(items, data(), mSize * sizeof(Node*));
+        mHeap = items;
+        mCapacity = capacity;
+    }
+
     template <>
-    Node::GraphIt TreeGraph<Node>::countChildren() const {
+    Node::GraphIt TreeGraph<Node, const Interner*>::countChildren() const {
         return std::make_pair(mNode.Children.begin(), mNode.Children.end());
     }
 
     template <>
-    bool TreeGraph<Node>::isOneliner() const { return !mNode.Children.empty(); }
+    bool TreeGraph<Node, const Interner*>::isOneliner() const { return !mNode.Children.empty(); }
 
     template <>
-    const Node& TreeGraph<Node>::getNode(const Iterator& it) const {
+    const Node& TreeGraph<Node, const Interner*>::getNode(const Iterator& it) const {
         return *(*it);
     }
 
     template <>
-    std::string TreeGraph<Node>::createAtom() const { return mNode.toString(); }
-}
\ No newline at end of file
+    std::string TreeGraph<Node, const Interner*>::createAtom() const { return mNode.toString(true, mContext); }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+namespace {
+
+    struct Owning : cyntactic::Node {
+        explicit Owning(int& destroyed) : mDestroyed{destroyed} {}
+        ~Owning() { mDestroyed++; }
+        std::vector<int> Data{1, 2, 3};
+        int& mDestroyed;
+    };
+}
+
+TEST_CASE("AST arena keeps children in place and destroys owning nodes", "[node]")
+{
+    using cyntactic::Node;
+    int destroyed{0};
+    {
+        cyntactic::AstArena arena;
+        auto *parent = arena.make<Node>(Node::PROGRAM);
+        std::vector<Node*> made;
+        for (int i = 0; i < 1000; i++) {
+            made.push_back(arena.make<Node>(Node::LITERAL));
+            parent->Children.push_back(made.back(), arena);
+            if (i % 100 == 0) {
+                made.push_back(arena.make<Owning>(destroyed));
+                parent->Children.push_back(made.back(), arena);
+            }
+        }
+        CHECK(arena.nodes() == made.size() + 1);
+        REQUIRE(parent->Children.size() == made.size());
+        CHECK(std::equal(parent->Children.begin(), parent->Children.end(), made.begin()));
+        CHECK(parent->Children.front() == made.front());
+        CHECK(parent->Children.back() == made.back());
+
+        // a moved node keeps its children, inline or not
+        auto *binary = arena.make<Node>(Node::BINARY_EXPR);
+        binary->Children.push_back(made[0]);
+        binary->Children.push_back(made[1]);
+        auto copy = std::move(*binary);
+        CHECK(copy.Children[1] == made[1]);
+        auto program = std::move(*parent);
+        CHECK(program.Children.size() == made.size());
+        CHECK(destroyed == 0);
+    }
+    CHECK(destroyed == 10);
+}
+#endif
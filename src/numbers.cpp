@@ -0,0 +1,83 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "numbers.hpp"
+
+#include <charconv>
+
+namespace {
+
+    bool hasPrefix(std::string_view text, char lower)
+    {
+        return text.size() >= 2 && text[0] == '0' && (text[1] | 0x20) == lower;
+    }
+
+    cyntactic::num::Status status(std::from_chars_result res, const char *end)
+    {
+        if (res.ec == std::errc::result_out_of_range) {
+            return cyntactic::num::N_OUT_OF_RANGE;
+        }
+        if (res.ec != std::errc{} || res.ptr != end) {
+            return cyntactic::num::N_INVALID;
+        }
+        return cyntactic::num::N_OK;
+    }
+}
+
+namespace cyntactic::num {
+
+    Status integer(std::string_view text, int base, std::uint64_t& value)
+    {
+        if ((base == 16 && hasPrefix(text, 'x')) || (base == 2 && hasPrefix(text, 'b'))) {
+            text.remove_prefix(2);
+        }
+        const auto *end = text.data() + text.size();
+        return status(std::from_chars(text.data(), end, value, base), end);
+    }
+
+    Status real(std::string_view text, double& value)
+    {
+        auto format = std::chars_format::general;
+        if (hasPrefix(text, 'x')) {
+            text.remove_prefix(2);
+            format = std::chars_format::hex;
+        }
+        const auto *end = text.data() + text.size();
+        return status(std::from_chars(text.data(), end, value, format), end);
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("Numeric literals convert without exceptions", "[numbers]")
+{
+    using namespace cyntactic::num;
+    std::uint64_t i{0};
+    CHECK(integer("0x1F", 16, i) == N_OK);
+    CHECK(i == 31);
+    CHECK(integer("0b101", 2, i) == N_OK);
+    CHECK(i == 5);
+    CHECK(integer("017", 8, i) == N_OK);
+    CHECK(i == 15);
+    CHECK(integer("18446744073709551615", 10, i) == N_OK);
+    CHECK(i == UINT64_MAX);
+    CHECK(integer("18446744073709551616", 10, i) == N_OUT_OF_RANGE);
+    CHECK(integer("0x1FFFFFFFFFFFFFFFF", 16, i) == N_OUT_OF_RANGE);
+    CHECK(integer("0x", 16, i) == N_INVALID);
+
+    double d{0};
+    CHECK(real("1.5e3", d) == N_OK);
+    CHECK(d == 1500.0);
+    CHECK(real("0.25", d) == N_OK);
+    CHECK(d == 0.25);
+    CHECK(real("0x1.8p3", d) == N_OK);
+    CHECK(d == 12.0);
+    CHECK(real("0X10P-4", d) == N_OK);
+    CHECK(d == 1.0);
+    CHECK(real("1e400", d) == N_OUT_OF_RANGE);
+    CHECK(real("0x", d) == N_INVALID);
+    CHECK(real("1.5e3x", d) == N_INVALID);
+}
+#endif
@@ -4,9 +4,12 @@
 
 #include "exceptions.hpp"
 #include "ast/binexpr.hpp"
+#include "ast/error.hpp"
 #include "ast/import.hpp"
 #include "ast/identifier.hpp"
 #include "ast/literal.hpp"
+#include "lexspec.hpp"
+#include "numbers.hpp"
 #include "symbols.hpp"
 
 #include "parser.hpp"
@@ -18,42 +21,221 @@ namespace {
 
 namespace cyntactic {
 
+    Program Parser::parse(const std::filesystem::path& src)
+    {
+        return parse(SourceBuffer::open(src));
+    }
+
     Program Parser::parse(const std::string_view& code, const std::string_view& src)
     {
-        mTokenizer.reset(code, src);
+        return parse(SourceBuffer::view(code, std::string{src}));
+    }
+
+    Program Parser::parse(SourceBuffer::Ptr source)
+    {
+        mNames = std::make_shared<Interner>();
+        mSymbols = SymTable{};
+        mStrings = std::make_shared<Arena>();
+        mNodes = std::make_shared<AstArena>();
+        mDiagnostics.clear();
+        mPending.clear();
+        mDepth = 0;
+        mContext = nullptr;
+        if (!mShared) {
+            mSources = std::make_shared<SourceManager>();
+        }
+        mBase = mSources->add(source);
+        if (mLazy) {
+            mTokenizer.reset(*source);
+            mTokenizer.intern(mNames.get());
+            mTokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+            mTokenizer.recover(mRecover);
+            mTokens = TokenBuffer{source->code()};
+            lex();
+            // the filter and the limit hold for the bodies too
+            auto deferred = std::make_shared<DiagnosticEngine>(mDiagnostics);
+            mContext = mNodes->make<ast::Block::Context>(
+                    ast::Block::Context{source, mSources, mNames, mStrings, mNodes, mBase, deferred, mRecover});
+        }
+        else if (mPipelined) {
+            mPipeline = std::make_unique<TokenPipeline>(*source, mNames.get(), TokenPipeline::BatchSize, mRecover);
+            mPipeline->next(mTokens);
+        }
+        else {
+            mTokenizer.reset(*source);
+            mTokenizer.intern(mNames.get());
+            mTokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+            mTokenizer.recover(mRecover);
+            mTokens = mTokenizer.tokenizeAll();
+        }
+        mIndex = 0;
+        mLookahead = mTokens[mIndex];
         Program pg;
-        advance();
-        while (!is(Token::T_EOF))
+        pg.Names = mNames;
+        pg.Strings = mStrings;
+        pg.Nodes = mNodes;
+        pg.Buffer = std::move(source);
+        pg.Sources = mSources;
+        if (mContext) {
+            pg.Diagnostics = mContext->Diagnostics;
+        }
+        try {
+            statements(pg.Children);
+        }
+        catch (...) {
+            // stops the lexer thread, it may be blocked waiting for us
+            mPipeline.reset();
+            throw;
+        }
+        mPipeline.reset();
+
+        return std::move(pg);
+    }
+
+    void Parser::expand(ast::Block& block)
+    {
+        auto& context = *block.Source;
+        mNames = context.Names;
+        mSymbols = SymTable{};
+        mStrings = context.Strings;
+        mNodes = context.Nodes.lock();
+        mSources = context.Sources;
+        mBase = context.Base;
+        mContext = &context;
+        mPending.clear();
+        mLazy = true;
+        mRecover = context.Recover;
+        mTokenizer.reset(*context.Buffer);
+        mTokenizer.intern(mNames.get());
+        mTokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+        mTokenizer.recover(mRecover);
+        mTokenizer.seek(block.Offset);
+        mTokens = TokenBuffer{context.Buffer->code()};
+        lex();
+        mLookahead = mTokens[mIndex];
+
+        // the block is left untouched if its body has errors it cannot recover from,
+        // what is reported goes to the program, not to this parser
+        NodeList body;
+        mDepth = 1;
+        std::swap(mDiagnostics, *context.Diagnostics);
+        try {
+            statements(body);
+            expect(Diagnostic::D_EXPECTING_BLOCK_END, Token::RBRACE);
+        }
+        catch (Abandon&) {
+            // the error limit was reached within the body
+            std::swap(mDiagnostics, *context.Diagnostics);
+            return;
+        }
+        catch (...) {
+            std::swap(mDiagnostics, *context.Diagnostics);
+            throw;
+        }
+        std::swap(mDiagnostics, *context.Diagnostics);
+        block.Children = body;
+        block.Source = nullptr;
+    }
+
+    void Parser::statements(NodeList& list)
+    {
+        while (!is(Token::T_EOF) && !(mDepth && is(Token::RBRACE)) && !mDiagnostics.full())
         {
-            eatWhiteSpace();
-            switch (mLookahead.kind) {
-                case Token::IMPORT: {
-                    pg.Children.push_back(importExpr());
-                    break;
-                }
-                case Token::COMMENT:
-                    advance(true); // ignore all comments
-                    break;
-                default: {
-                    pg.Children.push_back(binaryExpr());
-                    expectAdvance("expression's missing terminal semi-colon ';'", Token::SEMICOLON);
-                    break;
-                }
+            auto start = mTokens.offset(mIndex);
+            try {
+                list.push_back(statement(), *mNodes);
+            }
+            catch (Abandon&) {
+                mPending.clear();
+                list.push_back(synchronize(start), *mNodes);
             }
-            eatWhiteSpace();
         }
+    }
 
-        return std::move(pg);
+    Node::Ptr Parser::statement()
+    {
+        switch (mLookahead.kind) {
+            case Token::IMPORT:
+                return importExpr();
+            case Token::LBRACE:
+                return block();
+            default: {
+                auto node = binaryExpr();
+                expectAdvance(Diagnostic::D_EXPECTING_SEMICOLON, Token::SEMICOLON);
+                return node;
+            }
+        }
+    }
+
+    Node::Ptr Parser::synchronize(std::size_t start)
+    {
+        // every token is skipped at most once, even if every statement is broken
+        auto end = mTokens.offset(mIndex);
+        auto atStart = end == start;
+        for (;;) {
+            auto kind = mLookahead.kind;
+            if (kind == Token::T_EOF) {
+                break;
+            }
+            // a statement that failed on its first token would fail there again
+            if (!atStart && (kind == Token::IMPORT || kind == Token::FUNC || kind == Token::STRUCT)) {
+                break;
+            }
+            // the end of the block the statement is in
+            if (!atStart && mDepth && kind == Token::RBRACE) {
+                break;
+            }
+            end = mTokens.end(mIndex);
+            advance();
+            if (kind == Token::RBRACE && is(Token::SEMICOLON)) {
+                // the '}' closed a list ending a statement, e.g import a.{b c};
+                continue;
+            }
+            if (kind == Token::SEMICOLON || kind == Token::RBRACE) {
+                break;
+            }
+            atStart = false;
+        }
+        // the tokens parsed before the error are skipped too, not the space after them
+        auto code = mTokens.code();
+        while (end > start && lex::is(code[end - 1], lex::F_SPACE)) {
+            end--;
+        }
+        auto *node = mNodes->make<ast::Error>(mTokens.code().substr(start, end - start));
+        node->Loc = mBase + start;
+        return node;
+    }
+
+    template<typename ...Args>
+    void Parser::syntaxError(Diagnostic::Code code, Args&&... args)
+    {
+        auto loc = mBase + mTokens.offset(mIndex);
+        if (!mRecover) {
+            Diagnostic diag{code, Diagnostic::ERROR, loc, {Diagnostic::Arg{std::forward<Args>(args)}...}};
+            std::stringstream ss;
+            diag.message(ss);
+            auto [file, line, column] = mSources->decode(loc);
+            throw SyntaxError(file, line, column, ss.str());
+        }
+        if (is(Token::ERROR)) {
+            // the parser got stuck on a lexical error, which is what needs fixing
+            if (mLookahead.error() == Token::E_UNEXPECTED_CHAR) {
+                mDiagnostics.report(Diagnostic::ERROR, Diagnostic::D_UNEXPECTED_CHAR, loc, mLookahead.Value);
+            }
+            else {
+                mDiagnostics.report(Diagnostic::ERROR, Diagnostic::D_LEXICAL, loc, Token::message(mLookahead.error()));
+            }
+        }
+        else {
+            mDiagnostics.report(Diagnostic::ERROR, code, loc, std::forward<Args>(args)...);
+        }
+        throw Abandon{};
     }
 
     template<typename ...Args>
-    void Parser::syntaxError(Args&... args)
+    void Parser::error(Diagnostic::Code code, Args&&... args)
     {
-        throw SyntaxError(
-                mTokenizer.source(),
-                mTokenizer.line(),
-                mTokenizer.column(),
-                std::forward<Args>(args)...);
+        mDiagnostics.report(Diagnostic::ERROR, code, mBase + mTokens.offset(mIndex), std::forward<Args>(args)...);
     }
 
     template <typename... T>
@@ -71,37 +253,34 @@ namespace cyntactic {
     }
 
     template<typename... T>
-    void Parser::expectAdvance(const std::string_view& msg, Token::Kind kind, T&&... kinds)
+    void Parser::expectAdvance(Diagnostic::Code code, Token::Kind kind, T&&... kinds)
     {
-        expect(msg, kind, std::forward<T>(kinds)...);
+        expect(code, kind, std::forward<T>(kinds)...);
         advance();
     }
 
     template<typename... T>
-    void Parser::expect(const std::string_view& msg, Token::Kind kind, T&&... kinds)
+    void Parser::expect(Diagnostic::Code code, Token::Kind kind, T&&... kinds)
     {
         if (!expectCheck(kind, std::forward<T>(kinds)...)) {
-            syntaxError(msg);
+            syntaxError(code);
         }
     }
 
     template<typename T, typename... Args>
     Node::Ptr Parser::mkNode(Args&&... args)
     {
-        Node::Ptr node = std::make_unique<T>(std::forward<Args>(args)...);
-        node->Source = mLookahead.Source;
-        node->Line = mLookahead.Line;
-        node->Column = mLookahead.Column;
-        return std::move(node);
+        Node::Ptr node = mNodes->make<T>(std::forward<Args>(args)...);
+        node->Loc = mBase + mTokens.offset(mIndex);
+        return node;
     }
 
     void Parser::commaSeperatedIdentifier(TokenFunc onIdent)
     {
         auto consumeIdentifier = [&] {
-            eatWhiteSpace();
-            expect("unexpected token, expecting identifier", Token::IDENTIFIER);
+            expect(Diagnostic::D_EXPECTING_IDENTIFIER, Token::IDENTIFIER);
             onIdent(mLookahead);
-            advance(true);
+            advance();
         };
 
         consumeIdentifier();
@@ -112,97 +291,168 @@ namespace cyntactic {
         }
     }
 
-    void Parser::advance(bool eatWs)
+    void Parser::advance()
     {
-        mLookahead = mTokenizer.next();
-        if (eatWs) eatWhiteSpace();
+        // the buffer always ends with T_EOF, which is never advanced past
+        if (mIndex + 1 < mTokens.size()) {
+            mIndex++;
+        }
+        else if (mPipeline && !is(Token::T_EOF)) {
+            mPipeline->next(mTokens);
+            mIndex = 0;
+        }
+        else if (mLazy && !is(Token::T_EOF)) {
+            lex();
+        }
+        mLookahead = mTokens[mIndex];
     }
 
-    Node::Ptr Parser::advance(Node::Ptr &&node, bool eatWs)
+    void Parser::lex()
     {
-        advance(eatWs);
-        return std::move(node);
+        // a batch ends at each brace, so that the body after a '{' can be skipped
+        // before any of it is lexed and a body being expanded is not lexed past
+        mTokens.clear();
+        Token token;
+        do {
+            token = mTokenizer.next();
+            mTokens.push(token);
+        } while (token.kind != Token::T_EOF && token.kind != Token::LBRACE &&
+                 token.kind != Token::RBRACE && mTokens.size() < TokenPipeline::BatchSize);
+        mIndex = 0;
     }
 
-    void Parser::eatWhiteSpace()
+    Node::Ptr Parser::advance(Node::Ptr node)
     {
-        while (is(Token::WHITESPACE))
-            advance();
+        advance();
+        return node;
     }
 
     Node::Ptr Parser::integerLiteral(int base)
     {
-        auto str = std::string{mLookahead.Value};
-        return advance(
-                mkNode<ast::Literal>(std::stoull(str, nullptr, base)),
-                true);
+        std::uint64_t value{0};
+        switch (num::integer(mLookahead.Value, base, value)) {
+            case num::N_OK:
+                break;
+            case num::N_OUT_OF_RANGE:
+                error(Diagnostic::D_INTEGER_RANGE, mLookahead.Value);
+                break;
+            default:
+                error(Diagnostic::D_INTEGER_INVALID, mLookahead.Value);
+                break;
+        }
+        return advance(mkNode<ast::Literal>(value));
+    }
+
+    Node::Ptr Parser::floatLiteral()
+    {
+        double value{0};
+        switch (num::real(mLookahead.Value, value)) {
+            case num::N_OK:
+                break;
+            case num::N_OUT_OF_RANGE:
+                error(Diagnostic::D_FLOAT_RANGE, mLookahead.Value);
+                break;
+            default:
+                error(Diagnostic::D_FLOAT_INVALID, mLookahead.Value);
+                break;
+        }
+        return advance(mkNode<ast::Literal>(value));
     }
 
     Node::Ptr Parser::charLiteral()
     {
+        const auto& value = mLookahead.Value;
+        auto c = (value[0] == '\\')? lex::unescape(value[1]) : value[0];
         return advance(
-                mkNode<ast::Literal>(mLookahead.Value[0]),
-                true);
+                mkNode<ast::Literal>(c));
     }
 
     Node::Ptr Parser::stringLiteral()
     {
+        auto raw = mLookahead.Value;
+        if (raw.find('\\') == std::string_view::npos) {
+            // the program keeps the code alive, most literals are used in place
+            return advance(mkNode<ast::Literal>(raw));
+        }
+        auto *out = static_cast<char*>(mStrings->allocate(raw.size(), 1));
         return advance(
-                mkNode<ast::Literal>(std::string{mLookahead.Value}),
-                true);
+                mkNode<ast::Literal>(std::string_view{out, lex::unescape(raw, out)}));
     }
 
     Node::Ptr Parser::boolLiteral()
     {
         return advance(
-                mkNode<ast::Literal>(mLookahead.Value == "true"),
-                true);
+                mkNode<ast::Literal>(mLookahead.Value == "true"));
     }
 
-    Node::Ptr Parser::importExpr()
+    Node::Ptr Parser::block()
     {
-        expectAdvance("unexpected token, expecting 'import'", Token::IMPORT);
-        expectAdvance("'import' keyword should be followed by 1 or more spaces", Token::WHITESPACE);
-        expect("invalid import statement, expecting name of module", Token::IDENTIFIER);
+        auto *node = static_cast<ast::Block*>(mkNode<ast::Block>());
+        // a '{' always ends a batch, the tokenizer is right after it
+        auto offset = mTokens.offset(mIndex) + 1;
+        if (mLazy && mTokenizer.skipBody()) {
+            node->Source = mContext;
+            node->Offset = std::uint32_t(offset);
+            node->Size = std::uint32_t(mTokenizer.offset() - 1 - offset);
+            lex();
+            mLookahead = mTokens[mIndex];
+            return node;
+        }
 
-        auto node = std::make_unique<ast::Import>();
-        node->Name = std::string{mLookahead.Value};
+        // eagerly, or when the body is not closed and its errors have to be found
+        advance();
+        mDepth++;
+        statements(node->Children);
+        mDepth--;
+        expectAdvance(Diagnostic::D_EXPECTING_BLOCK_END, Token::RBRACE);
+        return node;
+    }
+
+    Node::Ptr Parser::importExpr()
+    {
+        // 'import' is always separated from the module name, otherwise they would lex as one identifier
+        auto loc = mBase + mTokens.offset(mIndex);
+        expectAdvance(Diagnostic::D_EXPECTING_IMPORT, Token::IMPORT);
+        expect(Diagnostic::D_EXPECTING_MODULE, Token::IDENTIFIER);
+
+        auto *node = mNodes->make<ast::Import>();
+        node->Loc = loc;
+        node->Name = mLookahead.Id;
         advance();
 
         if (is(Token::DOT)) {
             advance();
             if (is(Token::IDENTIFIER)) {
-                node->Symbols.emplace_back(mLookahead.Value);
+                node->Symbols.push_back(mLookahead.Id);
                 advance();
             }
             else {
-                expectAdvance("unexpected token, expecting '{' or symbol name",Token::LBRACE);
+                expectAdvance(Diagnostic::D_EXPECTING_SYMBOLS, Token::LBRACE);
                 commaSeperatedIdentifier([&](const Token& tok) {
-                    node->Symbols.emplace_back(tok.Value);
+                    node->Symbols.push_back(tok.Id);
                 });
-                expectAdvance("unexpected token, expecting '}' to import symbols", Token::RBRACE);
+                expectAdvance(Diagnostic::D_EXPECTING_SYMBOLS_END, Token::RBRACE);
             }
         }
 
-        eatWhiteSpace();
         if (is(Token::RARROW)) {
-            advance(true);
-            expect("unexpected token, expecting the name of the symbol ", Token::IDENTIFIER);
-            node->Alias = mLookahead.Value;
-            advance(true);
+            advance();
+            expect(Diagnostic::D_EXPECTING_ALIAS, Token::IDENTIFIER);
+            node->Alias = mLookahead.Id;
+            advance();
         }
-        expectAdvance("import statement must be terminated by a ';'", Token::SEMICOLON);
-        return std::move(node);
+        expectAdvance(Diagnostic::D_IMPORT_TERMINATOR, Token::SEMICOLON);
+        return node;
     }
 
     Node::Ptr Parser::primaryExpr()
     {
         switch (mLookahead.kind) {
             case Token::IDENTIFIER: {
-                if (!SymTable::isDefined(mLookahead.Value)) {
-                    syntaxError("variable '", mLookahead.Value, "' not defined");
+                if (!mSymbols.isDefined(mLookahead.Id)) {
+                    syntaxError(Diagnostic::D_UNDEFINED_VARIABLE, mLookahead.Value);
                 }
-                return advance(mkNode<ast::Identifier>(mLookahead.Value), true);
+                return advance(mkNode<ast::Identifier>(mLookahead.Id));
             }
             case Token::HEX_LITERAL:
                 return integerLiteral(16);
@@ -212,6 +462,8 @@ namespace cyntactic {
                 return integerLiteral(8);
             case Token::DEC_LITERAL:
                 return integerLiteral(10);
+            case Token::FLOAT_LITERAL:
+                return floatLiteral();
             case Token::CHAR_LITERAL:
                 return charLiteral();
             case Token::BOOL_LITERAL:
@@ -219,44 +471,374 @@ namespace cyntactic {
             case Token::STRING:
                 return stringLiteral();
             default:
-                syntaxError("unexpected token, expecting primary-expression");
+                syntaxError(Diagnostic::D_EXPECTING_PRIMARY);
         }
 
         return nullptr;
     }
 
-    Node::Ptr Parser::binaryExpr(unsigned int precedence)
+    Node::Ptr Parser::binaryExpr()
     {
         auto getOperator = [&]() {
             auto op = ast::BinaryOpInfo::find(mLookahead.kind);
             if (!op) {
-                syntaxError("unexpected token, expecting binary operator");
+                syntaxError(Diagnostic::D_EXPECTING_OPERATOR);
             }
             return op;
         };
+        // operators parsed before `op` that take their right operand before it does
+        auto bindsBefore = [](const ast::BinaryOpInfo& pending, const ast::BinaryOpInfo& op) {
+            return pending.Precedence > op.Precedence ||
+                   (pending.Precedence == op.Precedence && op.Assoc == ast::BinaryOpInfo::LEFT);
+        };
+        // precedence climbing with an explicit stack, an expression can be as
+        // long and as deeply nested as memory allows
+        auto base = mPending.size();
+        auto reduce = [&](Node::Ptr right) {
+            auto [op, left] = mPending.back();
+            mPending.pop_back();
+            auto node = mkNode<ast::BinaryExpr>(op, left, right);
+            // an expression starts with its left operand
+            node->Loc = left->Loc;
+            return node;
+        };
 
-        Node::Ptr left{nullptr}, right{nullptr};
-        left = primaryExpr();
-        if (is(Token::SEMICOLON) || is(Token::T_EOF)) {
-            return std::move(left);
+        auto operand = primaryExpr();
+        while (!is(Token::SEMICOLON) && !is(Token::T_EOF)) {
+            auto op = getOperator();
+            while (mPending.size() > base && bindsBefore(mPending.back().first, op)) {
+                operand = reduce(operand);
+            }
+            mPending.emplace_back(op, operand);
+            advance();
+            operand = primaryExpr();
+        }
+        while (mPending.size() > base) {
+            operand = reduce(operand);
         }
+        return operand;
+    }
+}
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("String literals point into the code unless they have escapes", "[parser]")
+{
+    using namespace cyntactic;
+    Parser parser;
+    std::string_view input{"\"plain text\";\n\"tab\\there \\\"quoted\\\" \\${x}\\\\\";\n"};
+    auto pg = parser.parse(input, "<test>");
+    REQUIRE(pg.Children.size() == 2);
+    auto& plain = static_cast<ast::Literal&>(*pg.Children.front());
+    auto& escaped = static_cast<ast::Literal&>(*pg.Children.back());
+
+    // the code is parsed where it is, not copied
+    auto code = pg.Buffer->code();
+    CHECK(code.data() == input.data());
+    CHECK_FALSE(pg.Buffer->padded());
+    auto text = plain.get<std::string_view>();
+    CHECK(text == "plain text");
+    CHECK(text.data() > code.data());
+    CHECK(text.data() < code.data() + code.size());
+
+    CHECK(escaped.get<std::string_view>() == "tab\there \"quoted\" ${x}\\");
+    CHECK(pg.Strings->blocks() == 1);
+    CHECK(pg.Nodes->nodes() == 2);
+}
 
-        auto op = getOperator();
+TEST_CASE("A parser only keeps the sources it parsed when they are shared", "[parser]")
+{
+    using namespace cyntactic;
+    Parser parser;
+    std::weak_ptr<const SourceBuffer> first;
+    {
+        auto pg = parser.parse(std::string_view{"1;"}, "<first>");
+        first = pg.Buffer;
+    }
+    auto pg = parser.parse(std::string_view{"2;"}, "<second>");
+    CHECK(first.expired());
+    CHECK(pg.Sources->files() == 1);
+
+    auto shared = std::make_shared<SourceManager>();
+    parser.sources(shared);
+    auto a = parser.parse(std::string_view{"1;"}, "<a>");
+    auto b = parser.parse(std::string_view{"2;"}, "<b>");
+    CHECK(shared->files() == 2);
+    CHECK(a.Sources == shared);
+    CHECK(b.Children.front()->Loc.Raw > a.Children.front()->Loc.Raw);
+}
 
-        while (op.Precedence > precedence) {
-            advance(true);
+TEST_CASE("Pipelined parsing matches parsing pre-tokenized code", "[parser]")
+{
+    using namespace cyntactic;
+    std::string code;
+    while (code.size() < (1 << 16)) {
+        code += "import mod.{a, b} -> m;\n1 + 2 * 3 - 0x1F == 'c';\n\"str\\n\" + 1.5;\n";
+    }
+    auto dump = [](const Program& pg) {
+        std::stringstream ss;
+        pg.dump(ss);
+        return ss.str();
+    };
+
+    Parser parser;
+    auto expected = dump(parser.parse(code, "<test>"));
+    parser.pipelined(true);
+    CHECK(dump(parser.parse(code, "<test>")) == expected);
+
+    // errors surface in the order of the code, the lexer stopped further on
+    CHECK_THROWS_WITH(parser.parse(code + "1 +;\n#", "<test>"),
+                      Catch::Contains("expecting primary-expression"));
+    CHECK_THROWS_WITH(parser.parse(code + "1 + #;\n", "<test>"),
+                      Catch::Contains("Unexpected '#'"));
+}
+TEST_CASE("Literals that do not convert are reported without stopping the parse", "[parser]")
+{
+    using namespace cyntactic;
+    Parser parser;
+    auto pg = parser.parse("0xFFFFFFFFFFFFFFFFF + 1e400 + 1.5;", "<test>");
+    REQUIRE(pg.Children.size() == 1);
+    REQUIRE(parser.diagnostics().size() == 2);
+    CHECK(parser.diagnostics()[0].code == Diagnostic::D_INTEGER_RANGE);
+    CHECK(parser.diagnostics()[1].code == Diagnostic::D_FLOAT_RANGE);
+    CHECK(DiagnosticEngine::render(parser.diagnostics()[1], *pg.Sources) ==
+          "<test>:1:23: error(syntax): floating point literal '1e400' is out of range");
+    CHECK(Diagnostic::format(Diagnostic::D_FLOAT_INVALID) == "invalid floating point literal '{0}'");
+}
 
-            right = binaryExpr(op.Precedence);
-            left  = mkNode<ast::BinaryExpr>(
-                        op, std::move(left), std::move(right));
+TEST_CASE("Binary operators follow C precedence and associativity", "[parser]")
+{
+    using namespace cyntactic;
+    std::function<std::string(const Node&)> sexpr = [&](const Node& node) {
+        if (node.Tag != Node::BINARY_EXPR) {
+            return node.toString();
+        }
+        const auto& expr = static_cast<const ast::BinaryExpr&>(node);
+        return "(" + sexpr(*node.Children[0]) + " " + std::string{expr.Op.Str} + " " + sexpr(*node.Children[1]) + ")";
+    };
+    auto parse = [&](std::string_view code) {
+        Parser parser;
+        auto pg = parser.parse(code, "<test>");
+        REQUIRE(pg.Children.size() == 1);
+        return sexpr(*pg.Children.front());
+    };
+
+    CHECK(parse("1 - 2 - 3;") == "((1 - 2) - 3)");
+    CHECK(parse("1 = 2 += 3;") == "(1 = (2 += 3))");
+    CHECK(parse("1 + 2 == 3 * 4 % 5;") == "((1 + 2) == ((3 * 4) % 5))");
+    CHECK(parse("1 || 2 && 3 | 4 ^ 5 & 6 != 7 < 8 << 9 - 10 / 11;") ==
+          "(1 || (2 && (3 | (4 ^ (5 & (6 != (7 < (8 << (9 - (10 / 11))))))))))");
+    CHECK(parse("1 <<= 2 >> 3 >= 4;") == "(1 <<= ((2 >> 3) >= 4))");
+
+    // every operator in the table is parsed as a binary expression
+    for (const auto& op: ast::BinaryOperators) {
+        auto code = "1 " + std::string{op.Info.Str} + " 2;";
+        CHECK(parse(code) == "(1 " + std::string{op.Info.Str} + " 2)");
+    }
+}
 
-            if (is(Token::SEMICOLON) || is(Token::T_EOF)) {
-                return std::move(left);
+TEST_CASE("Long and deeply nested expressions do not exhaust the stack", "[parser]")
+{
+    using namespace cyntactic;
+    // depth of the deepest node, walked with a stack of our own
+    auto depth = [](const Node& root) {
+        std::size_t deepest{0};
+        std::vector<std::pair<const Node*, std::size_t>> pending{{&root, 1}};
+        while (!pending.empty()) {
+            auto [node, level] = pending.back();
+            pending.pop_back();
+            deepest = std::max(deepest, level);
+            for (const auto& child: node->Children) {
+                pending.emplace_back(child, level + 1);
             }
+        }
+        return deepest;
+    };
+
+    constexpr std::size_t Terms{200000};
+    std::string sum{"1"}, chain{"2"};
+    for (std::size_t i = 1; i < Terms; i++) {
+        sum += " + 1";
+        chain += " = 2";
+    }
+    Parser parser;
+    // left associative, nested down the left operands
+    auto pg = parser.parse(sum + ";", "<test>");
+    REQUIRE(pg.Children.size() == 1);
+    CHECK(depth(*pg.Children.front()) == Terms);
+    CHECK(pg.Children.front()->Children.back()->toString() == "1");
+    // right associative, nested down the right operands
+    pg = parser.parse(chain + ";", "<test>");
+    REQUIRE(pg.Children.size() == 1);
+    CHECK(depth(*pg.Children.front()) == Terms);
+    CHECK(pg.Children.front()->Children.front()->toString() == "2");
+    // both at once, each operand of the sum is a product
+    pg = parser.parse("1 * 2 + 3 * 4 = 5 + 6 * 7 - 8;", "<test>");
+    CHECK(depth(*pg.Children.front()) == 5);
+}
+
+TEST_CASE("Recovering parser reports every broken statement in one pass", "[parser]")
+{
+    using namespace cyntactic;
+    const std::string code =
+            "1 + 2;\n"
+            "3 + ;\n"             // missing operand, resumes after the ';'
+            "4 5 } 6 + 7;\n"      // resumes after the '}'
+            "8 * # 9;\n"          // lexical error
+            "10 + import a;\n"    // resumes at the import
+            ";\n"                 // a lone ';' is skipped on its own
+            "func 11;\n"          // a keyword that cannot start a statement is skipped
+            "import b.{c d};\n"   // the ';' after a '}' goes with it
+            "12 - 13;\n";
+    for (bool pipelined: {false, true}) {
+        Parser parser;
+        parser.recover(true);
+        parser.pipelined(pipelined);
+        auto pg = parser.parse(code, "<test>");
+        std::vector<std::string> nodes;
+        for (const auto& child: pg.Children) {
+            nodes.push_back(child->Tag == Node::ERROR?
+                    "<" + std::string{static_cast<const ast::Error&>(*child).Code} + ">" : child->toString(true, pg.Names.get()));
+        }
+        CHECK(nodes == std::vector<std::string>{"+", "<3 + ;>", "<4 5 }>", "+", "<8 * # 9;>", "<10 +>",
+                                                "Import (a)", "<;>", "<func 11;>",
+                                                "<import b.{c d};>", "-"});
 
-            op = getOperator();
+        std::vector<std::string> messages;
+        for (const auto& diag: parser.diagnostics()) {
+            messages.push_back(DiagnosticEngine::render(diag, *pg.Sources));
         }
+        CHECK(messages == std::vector<std::string>{
+            "<test>:2:5: error(syntax): unexpected token, expecting primary-expression",
+            "<test>:3:3: error(syntax): unexpected token, expecting binary operator",
+            "<test>:4:5: error(syntax): unexpected character '#'",
+            "<test>:5:6: error(syntax): unexpected token, expecting primary-expression",
+            "<test>:6:1: error(syntax): unexpected token, expecting primary-expression",
+            "<test>:7:1: error(syntax): unexpected token, expecting primary-expression",
+            "<test>:8:13: error(syntax): unexpected token, expecting '}' to import symbols"});
+    }
+
+    // without recovery the first error still stops the parse
+    Parser parser;
+    CHECK_THROWS_AS(parser.parse(code, "<test>"), SyntaxError);
+
+    // the text skipped keeps the closing quotes of the literals it ends with
+    parser.recover(true);
+    auto pg = parser.parse(std::string_view{"{ 1 'c' } { 2 \"str\" } 3;"}, "<test>");
+    REQUIRE(pg.Children.size() == 3);
+    CHECK(static_cast<const ast::Error&>(*pg.Children[0]->Children.front()).Code == "1 'c'");
+    CHECK(static_cast<const ast::Error&>(*pg.Children[1]->Children.front()).Code == "2 \"str\"");
+}
 
-        return std::move(left);
+TEST_CASE("Recovering from an error on every line takes a single pass", "[parser]")
+{
+    using namespace cyntactic;
+    constexpr std::size_t Lines{100000};
+    std::string code;
+    for (std::size_t i = 0; i < Lines; i++) {
+        code += "1 + * 2 } 3 + 4;\n";
     }
-}
\ No newline at end of file
+    Parser parser;
+    parser.recover(true);
+    auto pg = parser.parse(code, "<test>");
+    // each line is an error up to the '}' and the expression after it
+    CHECK(pg.Children.size() == 2 * Lines);
+    CHECK(parser.diagnostics().size() == Lines);
+    CHECK(pg.Children.back()->Tag == Node::BINARY_EXPR);
+
+    // the parse ends at the error limit
+    parser.diagnostics().limit(10);
+    pg = parser.parse(code, "<test>");
+    CHECK(parser.diagnostics().size() == 10);
+    CHECK(pg.Children.size() == 19);
+}
+
+TEST_CASE("Lazily parsed blocks match blocks parsed up front", "[parser]")
+{
+    using namespace cyntactic;
+    const std::string code =
+            "import a.{b, c};\n"
+            "{ 1 + 2; { \"}\" + 3; } 'x'; }\n"
+            "4 * 5;\n"
+            "{ /* { */ 6; }\n";
+    std::function<std::string(const Node&, const Interner&)> str = [&](const Node& node, const Interner& names) {
+        const auto& children = (node.Tag == Node::BLOCK)?
+                static_cast<const ast::Block&>(node).body() : node.Children;
+        auto out = node.toString(true, &names);
+        for (const auto& child: children) {
+            out += " (" + str(*child, names) + ")";
+        }
+        return out;
+    };
+
+    Parser parser;
+    auto eager = parser.parse(code, "<test>");
+    parser.lazy(true);
+    auto pg = parser.parse(code, "<test>");
+    REQUIRE(pg.Children.size() == 4);
+    const auto& outer = static_cast<const ast::Block&>(*pg.Children[1]);
+    REQUIRE(outer.Tag == Node::BLOCK);
+    CHECK(outer.lazy());
+    CHECK(outer.Children.empty());
+    CHECK(code.substr(outer.Offset, outer.Size) == " 1 + 2; { \"}\" + 3; } 'x'; ");
+    CHECK(pg.Nodes->nodes() == 6);
+
+    // blocks in a body being expanded are skipped in turn
+    REQUIRE(outer.body().size() == 3);
+    CHECK_FALSE(outer.lazy());
+    CHECK(static_cast<const ast::Block&>(*outer.body()[1]).lazy());
+    auto [file, line, column] = pg.location(*outer.body()[2]);
+    CHECK(line == 2);
+    CHECK(column == 24);
+    CHECK(str(pg, *pg.Names) == str(eager, *eager.Names));
+    CHECK(str(pg, *pg.Names) == "Program (Import (a{...})) ({} (+ (1) (2)) ({} (+ (}) (3))) (x)) (* (4) (5)) ({} (6))");
+}
+
+TEST_CASE("Errors in lazily parsed blocks surface when they are parsed", "[parser]")
+{
+    using namespace cyntactic;
+    Parser parser;
+    parser.lazy(true);
+    auto pg = parser.parse("{ 1 + ; }\n2;", "<test>");
+    REQUIRE(pg.Children.size() == 2);
+    const auto& block = static_cast<const ast::Block&>(*pg.Children.front());
+    CHECK_THROWS_WITH(block.body(), Catch::Contains("<test>:1:7: error(syntax): unexpected token, expecting primary-expression"));
+    CHECK(block.lazy());
+
+    // a body that is never closed is parsed right away, to find where it went wrong
+    CHECK_THROWS_WITH(parser.parse("{ 1; \"}\";\n", "<test>"),
+                      Catch::Contains("expecting '}' to close the block"));
+
+    // recovering within a block stops at its end
+    parser.lazy(false);
+    parser.recover(true);
+    pg = parser.parse("{ 1 + ; 2 3 } 4;", "<test>");
+    REQUIRE(pg.Children.size() == 2);
+    const auto& body = pg.Children.front()->Children;
+    REQUIRE(body.size() == 2);
+    CHECK(body[0]->Tag == Node::ERROR);
+    CHECK(static_cast<const ast::Error&>(*body[1]).Code == "2 3");
+    CHECK(parser.diagnostics().size() == 2);
+
+    // problems that do not stop a parse are kept with the program
+    parser.lazy(true);
+    parser.recover(false);
+    pg = parser.parse("{ 0xFFFFFFFFFFFFFFFFFFFF; }", "<test>");
+    REQUIRE(pg.Diagnostics != nullptr);
+    CHECK(pg.Diagnostics->empty());
+    CHECK(static_cast<const ast::Block&>(*pg.Children.front()).body().size() == 1);
+    REQUIRE(pg.Diagnostics->size() == 1);
+    CHECK(DiagnosticEngine::render((*pg.Diagnostics)[0], *pg.Sources) ==
+          "<test>:1:3: error(syntax): integer literal '0xFFFFFFFFFFFFFFFFFFFF' does not fit in 64 bits");
+
+    // as are syntax errors when recovering
+    parser.recover(true);
+    pg = parser.parse("{ 1 + ; 2; }", "<test>");
+    const auto& recovered = static_cast<const ast::Block&>(*pg.Children.front());
+    REQUIRE(recovered.body().size() == 2);
+    CHECK(recovered.body()[0]->Tag == Node::ERROR);
+    REQUIRE(pg.Diagnostics->size() == 1);
+    CHECK((*pg.Diagnostics)[0].code == Diagnostic::D_EXPECTING_PRIMARY);
+    CHECK(parser.diagnostics().empty());
+}
+#endif
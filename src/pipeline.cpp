@@ -0,0 +1,209 @@
+//
+// Created by Mpho Mbotho on 2021-08-25.
+//
+
+#include "pipeline.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+
+namespace cyntactic {
+
+    TokenPipeline::TokenPipeline(const SourceBuffer& source, Interner *names, std::size_t batch, bool recover)
+        : mTokenizer{source},
+          mCode{source.code()},
+          mBatch{std::max<std::size_t>(batch, 1)}
+    {
+        mTokenizer.intern(names);
+        mTokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+        mTokenizer.recover(recover);
+        mThread = std::thread([this] { produce(); });
+    }
+
+    TokenPipeline::~TokenPipeline()
+    {
+        mFull.close();
+        mThread.join();
+    }
+
+    void TokenPipeline::produce()
+    {
+        Batch batch;
+        bool done{false};
+        do {
+            if (!mFree.tryPop(batch.Tokens)) {
+                batch.Tokens = TokenBuffer{mCode};
+                batch.Tokens.reserve(mBatch);
+            }
+            batch.Tokens.clear();
+            try {
+                while (batch.Tokens.size() < mBatch) {
+                    auto token = mTokenizer.next();
+                    batch.Tokens.push(token);
+                    if (token.kind == Token::T_EOF) {
+                        done = true;
+                        break;
+                    }
+                }
+            }
+            catch (...) {
+                batch.Error = std::current_exception();
+                done = true;
+            }
+        } while (mFull.push(std::move(batch)) && !done);
+    }
+
+    void TokenPipeline::next(TokenBuffer& tokens)
+    {
+        if (mError) {
+            std::rethrow_exception(mError);
+        }
+        if (mEnded) {
+            // the lexer is gone, the stream stays at its end
+            tokens.clear();
+            tokens.push({Token::T_EOF, mCode.substr(mCode.size())});
+            return;
+        }
+        if (mHolding) {
+            // handed back for reuse, dropped if the lexer already has enough spares
+            mFree.tryPush(std::move(tokens));
+        }
+
+        Batch batch;
+        // only the consumer closes the queue, the lexer always ends the stream itself
+        // and has queued its last batch before exiting
+        if (!mFull.pop(batch)) {
+            throw Exception("token pipeline closed before the end of the stream");
+        }
+        mError = batch.Error;
+        if (mError && batch.Tokens.size() == 0) {
+            std::rethrow_exception(mError);
+        }
+        tokens = std::move(batch.Tokens);
+        mHolding = true;
+        mEnded = tokens.kind(tokens.size() - 1) == Token::T_EOF;
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+namespace {
+
+    std::vector<cyntactic::Token::Kind> drain(cyntactic::TokenPipeline& pipeline, std::vector<std::size_t>& offsets)
+    {
+        using cyntactic::Token;
+        std::vector<Token::Kind> kinds;
+        cyntactic::TokenBuffer tokens;
+        do {
+            pipeline.next(tokens);
+            for (std::size_t i = 0; i < tokens.size(); i++) {
+                kinds.push_back(tokens.kind(i));
+                offsets.push_back(tokens.offset(i));
+            }
+        } while (kinds.back() != Token::T_EOF);
+        return kinds;
+    }
+}
+
+TEST_CASE("SPSC queue hands values over in order", "[pipeline]")
+{
+    cyntactic::SpscQueue<std::size_t, 4> queue;
+    std::size_t value{0};
+    CHECK_FALSE(queue.tryPop(value));
+    for (std::size_t i = 0; i < 4; i++) {
+        CHECK(queue.tryPush(std::size_t{i}));
+    }
+    CHECK_FALSE(queue.tryPush(4));
+
+    // the producer blocks on the full queue until the consumer catches up
+    constexpr std::size_t Count{100000};
+    std::thread producer([&] {
+        for (std::size_t i = 4; i < Count; i++) {
+            queue.push(std::size_t{i});
+        }
+    });
+    std::size_t expected{0};
+    bool ordered{true};
+    while (expected < Count && queue.pop(value)) {
+        ordered = ordered && (value == expected++);
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(expected == Count);
+
+    queue.close();
+    CHECK_FALSE(queue.pop(value));
+    CHECK_FALSE(queue.push(1));
+}
+
+TEST_CASE("Pipelined tokens match tokenizing everything at once", "[pipeline]")
+{
+    using namespace cyntactic;
+    std::string code;
+    while (code.size() < (1 << 18)) {
+        code += "import mod.{a, b};\nx <<= 0x1F + 'c' - \"str\";   // trailing\n";
+    }
+    auto source = SourceBuffer::copy(code, "<test>");
+    Tokenizer tokenizer{*source};
+    tokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+    auto expected = tokenizer.tokenizeAll();
+
+    for (std::size_t batch: {1, 7, 4096}) {
+        Interner names;
+        TokenPipeline pipeline{*source, &names, batch};
+        std::vector<std::size_t> offsets;
+        auto kinds = drain(pipeline, offsets);
+        REQUIRE(kinds.size() == expected.size());
+        bool same{true};
+        for (std::size_t i = 0; i < kinds.size(); i++) {
+            same = same && kinds[i] == expected.kind(i) && offsets[i] == expected.offset(i);
+        }
+        CHECK(same);
+        CHECK(names.find("mod") != Interner::None);
+    }
+
+    // abandoning the stream stops the lexer blocked on the full queue
+    Interner names;
+    TokenPipeline pipeline{*source, &names, 1};
+    TokenBuffer tokens;
+    pipeline.next(tokens);
+    CHECK(tokens.kind(0) == Token::IMPORT);
+
+    // past the end the stream keeps ending, instead of waiting on a lexer that is gone
+    Interner others;
+    TokenPipeline ended{*source, &others};
+    std::vector<std::size_t> offsets;
+    drain(ended, offsets);
+    for (int i = 0; i < 2; i++) {
+        ended.next(tokens);
+        REQUIRE(tokens.size() == 1);
+        CHECK(tokens.kind(0) == Token::T_EOF);
+        CHECK(tokens.offset(0) == offsets.back());
+    }
+}
+
+TEST_CASE("Lexer errors reach the pipeline consumer after the tokens before them", "[pipeline]")
+{
+    using namespace cyntactic;
+    auto source = SourceBuffer::copy("a + b;\nc # d;\n", "<test>");
+    Interner names;
+    TokenPipeline pipeline{*source, &names, 2};
+    TokenBuffer tokens;
+    std::vector<Token::Kind> kinds;
+    try {
+        for (;;) {
+            pipeline.next(tokens);
+            for (std::size_t i = 0; i < tokens.size(); i++) {
+                kinds.push_back(tokens.kind(i));
+            }
+        }
+    }
+    catch (SyntaxError&) {
+    }
+    CHECK(kinds == std::vector<Token::Kind>{Token::IDENTIFIER, Token::PLUS, Token::IDENTIFIER,
+                                            Token::SEMICOLON, Token::IDENTIFIER});
+    // the error sticks
+    CHECK_THROWS_AS(pipeline.next(tokens), SyntaxError);
+}
+#endif
@@ -6,14 +6,14 @@
 
 namespace cyntactic {
 
-    std::string Program::toString(bool compressed) const
+    std::string Program::toString(bool compressed, const Interner *names) const
     {
         return "Program";
     }
 
     void Program::dump(std::ostream& os) const
     {
-        TreeGraph<Node> graph(*this, 132-2);
+        TreeGraph<Node, const Interner*> graph(*this, 132-2, Names.get());
         TextBox dump{};
         dump.putbox(2, 0, graph());
         os << dump.toString();
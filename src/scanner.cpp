@@ -0,0 +1,509 @@
+//
+// Created by Mpho Mbotho on 2021-08-21.
+//
+
+#include "scanner.hpp"
+#include "unicode.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CYNT_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+    inline bool isWhiteSpace(unsigned char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    inline bool isIdentifier(unsigned char c)
+    {
+        return (c >= '0' && c <= '9') || c == '_' || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+    }
+
+    const char* scalarWhiteSpace(const char *p, const char *end)
+    {
+        while (p < end && isWhiteSpace(*p)) p++;
+        return p;
+    }
+
+    const char* scalarIdentifier(const char *p, const char *end)
+    {
+        while (p < end && isIdentifier(*p)) p++;
+        return p;
+    }
+
+    const char* scalarUtf8(const char *p, const char *end)
+    {
+        while (p < end) {
+            if (std::uint8_t(*p) < 0x80) {
+                p++;
+                continue;
+            }
+            auto n = cyntactic::utf8::sequence(p, end);
+            if (n == 0) return p;
+            p += n;
+        }
+        return p;
+    }
+
+    const char* scalarFind(const char *p, const char *end, char c)
+    {
+        while (p < end && *p != c) p++;
+        return p;
+    }
+
+    std::size_t scalarCount(const char *p, const char *end, char c)
+    {
+        std::size_t n{0};
+        for (; p < end; p++) n += (*p == c);
+        return n;
+    }
+
+    void scalarCollect(const char *p, const char *end, char c, std::vector<std::uint32_t>& out)
+    {
+        for (const char *it = p; it < end; it++) {
+            if (*it == c) out.push_back(std::uint32_t(it - p));
+        }
+    }
+
+    inline void pushBits(std::vector<std::uint32_t>& out, std::uint32_t base, unsigned mask)
+    {
+        while (mask) {
+            out.push_back(base + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+
+#ifdef CYNT_SCAN_X86
+    /*
+     * The class tests below rely on signed byte compares; every byte >= 0x80
+     * is negative and therefore falls outside of all the ASCII ranges tested.
+     */
+    inline __m128i sse2WhiteSpace(__m128i v)
+    {
+        auto t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+        auto ctrl = _mm_and_si128(_mm_cmpgt_epi8(t, _mm_set1_epi8(-1)),
+                                  _mm_cmplt_epi8(t, _mm_set1_epi8('\r' - '\t' + 1)));
+        return _mm_or_si128(ctrl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    }
+
+    inline __m128i sse2Identifier(__m128i v)
+    {
+        auto inRange = [](__m128i x, char lo, char hi) {
+            auto t = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+            return _mm_and_si128(_mm_cmpgt_epi8(t, _mm_set1_epi8(-1)),
+                                 _mm_cmplt_epi8(t, _mm_set1_epi8(char(hi - lo + 1))));
+        };
+        auto alpha = inRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+        auto digit = inRange(v, '0', '9');
+        auto under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+        return _mm_or_si128(_mm_or_si128(alpha, digit), under);
+    }
+
+    template <__m128i(*Class)(__m128i), bool(*Scalar)(unsigned char)>
+    const char* sse2Span(const char *p, const char *end)
+    {
+        for (; p + 16 <= end; p += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            unsigned mask = ~unsigned(_mm_movemask_epi8(Class(v))) & 0xFFFFu;
+            if (mask) return p + __builtin_ctz(mask);
+        }
+        while (p < end && Scalar(*p)) p++;
+        return p;
+    }
+
+    const char* sse2Utf8(const char *p, const char *end)
+    {
+        // without a byte shuffle there are no table lookups, only ASCII runs are vectorised
+        while (true) {
+            while (p + 16 <= end && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0) {
+                p += 16;
+            }
+            if (p + 16 > end) {
+                return scalarUtf8(p, end);
+            }
+            // the last sequence of the block may run into the next one
+            const char *stop = p + 16;
+            while (p < stop) {
+                auto n = cyntactic::utf8::sequence(p, end);
+                if (n == 0) return p;
+                p += n;
+            }
+        }
+    }
+
+    const char* sse2Find(const char *p, const char *end, char c)
+    {
+        auto needle = _mm_set1_epi8(c);
+        for (; p + 16 <= end; p += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+            if (mask) return p + __builtin_ctz(mask);
+        }
+        return scalarFind(p, end, c);
+    }
+
+    std::size_t sse2Count(const char *p, const char *end, char c)
+    {
+        std::size_t n{0};
+        auto needle = _mm_set1_epi8(c);
+        for (; p + 16 <= end; p += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+        }
+        return n + scalarCount(p, end, c);
+    }
+
+    void sse2Collect(const char *p, const char *end, char c, std::vector<std::uint32_t>& out)
+    {
+        auto needle = _mm_set1_epi8(c);
+        const char *it = p;
+        for (; it + 16 <= end; it += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            pushBits(out, std::uint32_t(it - p), _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+        }
+        for (; it < end; it++) {
+            if (*it == c) out.push_back(std::uint32_t(it - p));
+        }
+    }
+
+#define CYNT_AVX2 __attribute__((target("avx2")))
+
+    CYNT_AVX2 inline __m256i avx2WhiteSpace(__m256i v)
+    {
+        auto t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+        auto ctrl = _mm256_and_si256(_mm256_cmpgt_epi8(t, _mm256_set1_epi8(-1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' - '\t' + 1), t));
+        return _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+    }
+
+    CYNT_AVX2 inline __m256i avx2InRange(__m256i x, char lo, char hi)
+    {
+        auto t = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+        return _mm256_and_si256(_mm256_cmpgt_epi8(t, _mm256_set1_epi8(-1)),
+                                _mm256_cmpgt_epi8(_mm256_set1_epi8(char(hi - lo + 1)), t));
+    }
+
+    CYNT_AVX2 inline __m256i avx2Identifier(__m256i v)
+    {
+        auto alpha = avx2InRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        auto digit = avx2InRange(v, '0', '9');
+        auto under = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+        return _mm256_or_si256(_mm256_or_si256(alpha, digit), under);
+    }
+
+    CYNT_AVX2 const char* avx2WhiteSpaceSpan(const char *p, const char *end)
+    {
+        for (; p + 32 <= end; p += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            unsigned mask = ~unsigned(_mm256_movemask_epi8(avx2WhiteSpace(v)));
+            if (mask) return p + __builtin_ctz(mask);
+        }
+        return sse2Span<sse2WhiteSpace, isWhiteSpace>(p, end);
+    }
+
+    CYNT_AVX2 const char* avx2IdentifierSpan(const char *p, const char *end)
+    {
+        for (; p + 32 <= end; p += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            unsigned mask = ~unsigned(_mm256_movemask_epi8(avx2Identifier(v)));
+            if (mask) return p + __builtin_ctz(mask);
+        }
+        return sse2Span<sse2Identifier, isIdentifier>(p, end);
+    }
+
+    template <int N>
+    CYNT_AVX2 inline __m256i avx2Prev(__m256i input, __m256i prev)
+    {
+        // input shifted right by N bytes, with the last N bytes of prev shifted in
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+    }
+
+    CYNT_AVX2 inline __m256i avx2Lookup(__m256i nibbles, const char (&table)[16])
+    {
+        auto t = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+        return _mm256_shuffle_epi8(t, nibbles);
+    }
+
+    /*
+     * The lookup algorithm from Keiser and Lemire, "Validating UTF-8 In Less
+     * Than One Instruction Per Byte". Every pair of adjacent bytes is classified
+     * by three nibble lookups whose intersection is the set of errors the pair
+     * exhibits; continuation bytes that are required by a three or four byte
+     * lead are checked separately. Non-zero bytes in the result are errors.
+     */
+    CYNT_AVX2 inline __m256i avx2Utf8Errors(__m256i input, __m256i prev)
+    {
+        constexpr char TooShort = 1 << 0, TooLong = 1 << 1, Overlong3 = 1 << 2, TooLarge = 1 << 3,
+                       Surrogate = 1 << 4, Overlong2 = 1 << 5, TooLarge1000 = 1 << 6, Overlong4 = 1 << 6,
+                       TwoConts = char(1 << 7), Carry = TooShort | TooLong | TwoConts;
+        static constexpr char Byte1High[16] = {
+            // 0___ ASCII, 10__ continuation, 110_ 1110 and 1111 leads
+            TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+            TwoConts, TwoConts, TwoConts, TwoConts,
+            TooShort | Overlong2,
+            TooShort,
+            TooShort | Overlong3 | Surrogate,
+            TooShort | TooLarge | TooLarge1000 | Overlong4
+        };
+        static constexpr char Byte1Low[16] = {
+            Carry | Overlong3 | Overlong2 | Overlong4,
+            Carry | Overlong2,
+            Carry,
+            Carry,
+            Carry | TooLarge,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000 | Surrogate,
+            Carry | TooLarge | TooLarge1000,
+            Carry | TooLarge | TooLarge1000
+        };
+        static constexpr char Byte2High[16] = {
+            TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+            TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4,
+            TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge,
+            TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+            TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+            TooShort, TooShort, TooShort, TooShort
+        };
+
+        auto low = _mm256_set1_epi8(0x0F);
+        auto prev1 = avx2Prev<1>(input, prev);
+        auto special = _mm256_and_si256(
+            _mm256_and_si256(avx2Lookup(_mm256_and_si256(_mm256_srli_epi16(prev1, 4), low), Byte1High),
+                             avx2Lookup(_mm256_and_si256(prev1, low), Byte1Low)),
+            avx2Lookup(_mm256_and_si256(_mm256_srli_epi16(input, 4), low), Byte2High));
+
+        // the high bit is set for bytes two or three positions after a three or four byte lead
+        auto third = _mm256_subs_epu8(avx2Prev<2>(input, prev), _mm256_set1_epi8(char(0xE0 - 0x80)));
+        auto fourth = _mm256_subs_epu8(avx2Prev<3>(input, prev), _mm256_set1_epi8(char(0xF0 - 0x80)));
+        auto must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(char(0x80)));
+        return _mm256_xor_si256(must23, special);
+    }
+
+    inline std::size_t pending(const char *end)
+    {
+        // the number of bytes before end of a well formed sequence that continues past it
+        if (std::uint8_t(end[-1]) >= 0xC0) return 1;
+        if (std::uint8_t(end[-2]) >= 0xE0) return 2;
+        if (std::uint8_t(end[-3]) >= 0xF0) return 3;
+        return 0;
+    }
+
+    CYNT_AVX2 const char* avx2Utf8(const char *p, const char *end)
+    {
+        // blocks are only classified, the scalar validator locates the error from
+        // the last character boundary before the block that failed
+        auto prev = _mm256_setzero_si256();
+        const char *boundary = p;
+        for (; p + 32 <= end; p += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            if (_mm256_movemask_epi8(v) == 0) {
+                // an ASCII block cannot complete a sequence started in the previous one
+                if (boundary != p) break;
+                boundary = p + 32;
+            }
+            else {
+                auto errors = avx2Utf8Errors(v, prev);
+                if (!_mm256_testz_si256(errors, errors)) break;
+                boundary = p + 32 - pending(p + 32);
+            }
+            prev = v;
+        }
+        return scalarUtf8(boundary, end);
+    }
+
+    CYNT_AVX2 const char* avx2Find(const char *p, const char *end, char c)
+    {
+        auto needle = _mm256_set1_epi8(c);
+        for (; p + 32 <= end; p += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle));
+            if (mask) return p + __builtin_ctz(mask);
+        }
+        return sse2Find(p, end, c);
+    }
+
+    CYNT_AVX2 std::size_t avx2Count(const char *p, const char *end, char c)
+    {
+        std::size_t n{0};
+        auto needle = _mm256_set1_epi8(c);
+        for (; p + 32 <= end; p += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            n += __builtin_popcount(unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle))));
+        }
+        return n + sse2Count(p, end, c);
+    }
+
+    CYNT_AVX2 void avx2Collect(const char *p, const char *end, char c, std::vector<std::uint32_t>& out)
+    {
+        auto needle = _mm256_set1_epi8(c);
+        const char *it = p;
+        for (; it + 32 <= end; it += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            pushBits(out, std::uint32_t(it - p), unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle))));
+        }
+        for (; it < end; it++) {
+            if (*it == c) out.push_back(std::uint32_t(it - p));
+        }
+    }
+
+#undef CYNT_AVX2
+#endif
+
+    using cyntactic::scan::Isa;
+    using cyntactic::scan::Kernels;
+
+    bool supported(Isa isa)
+    {
+        switch (isa) {
+            case cyntactic::scan::SCALAR:
+                return true;
+#ifdef CYNT_SCAN_X86
+            case cyntactic::scan::SSE2:
+                return __builtin_cpu_supports("sse2");
+            case cyntactic::scan::AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    Kernels kernels(Isa isa)
+    {
+        switch (isa) {
+#ifdef CYNT_SCAN_X86
+            case cyntactic::scan::AVX2:
+                return {avx2WhiteSpaceSpan, avx2IdentifierSpan, avx2Utf8, avx2Find, avx2Count, avx2Collect};
+            case cyntactic::scan::SSE2:
+                return {sse2Span<sse2WhiteSpace, isWhiteSpace>,
+                        sse2Span<sse2Identifier, isIdentifier>,
+                        sse2Utf8, sse2Find, sse2Count, sse2Collect};
+#endif
+            default:
+                return {scalarWhiteSpace, scalarIdentifier, scalarUtf8, scalarFind, scalarCount, scalarCollect};
+        }
+    }
+
+    Isa best()
+    {
+        for (auto isa: {cyntactic::scan::AVX2, cyntactic::scan::SSE2}) {
+            if (supported(isa)) return isa;
+        }
+        return cyntactic::scan::SCALAR;
+    }
+
+    Isa gIsa{best()};
+}
+
+namespace cyntactic::scan {
+
+    Kernels gKernels{kernels(gIsa)};
+
+    Isa isa()
+    {
+        return gIsa;
+    }
+
+    Isa select(Isa isa)
+    {
+        gIsa = supported(isa)? isa : best();
+        gKernels = kernels(gIsa);
+        return gIsa;
+    }
+
+    std::string_view name(Isa isa)
+    {
+        switch (isa) {
+            case SCALAR: return "scalar";
+            case SSE2: return "sse2";
+            case AVX2: return "avx2";
+            default: return "unknown";
+        }
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+#include <iterator>
+#include <string>
+
+TEST_CASE("Scan kernels agree across instruction sets", "[scanner]")
+{
+    namespace scan = cyntactic::scan;
+    std::string text;
+    for (unsigned i = 0; i < 4096; i++) {
+        text.push_back(char((i * 2654435761u) >> 13));
+    }
+    text += std::string(70, ' ') + std::string(70, 'x') + "\n\t\r\v\f_09azAZ";
+
+    auto previous = scan::isa();
+    std::vector<std::size_t> results;
+    for (auto isa: {scan::SCALAR, scan::SSE2, scan::AVX2}) {
+        scan::select(isa);
+        std::vector<std::size_t> current;
+        const char *end = text.data() + text.size();
+        for (const char *p = text.data(); p < end; p++) {
+            current.push_back(scan::whitespace(p, end) - p);
+            current.push_back(scan::identifier(p, end) - p);
+            current.push_back(scan::utf8(p, end) - p);
+            current.push_back(scan::find(p, end, '\n') - p);
+            current.push_back(scan::count(p, end, 'x'));
+        }
+        std::vector<std::uint32_t> lines;
+        scan::collect(text.data(), text.data() + text.size(), '\n', lines);
+        for (auto line: lines) {
+            current.push_back(line);
+        }
+        if (results.empty()) {
+            results = std::move(current);
+        }
+        else {
+            REQUIRE(results == current);
+        }
+    }
+    scan::select(previous);
+}
+
+TEST_CASE("UTF-8 validation finds the first ill formed sequence", "[scanner]")
+{
+    namespace scan = cyntactic::scan;
+    // one and multi byte sequences crossing every block boundary, followed by an ASCII block.
+    // Every ill formed insertion below is followed by a lead or an ASCII byte, so it is
+    // reported exactly where it was inserted.
+    std::string text;
+    const char *pieces[] = {"a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF"};
+    for (unsigned i = 0; text.size() < 300; i++) {
+        text += pieces[(i * 7 + i / 5) % std::size(pieces)];
+    }
+    text += std::string(40, 'z');
+    const char *bad[] = {"\x80", "\xC0\xAF", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+                         "\xF8", "\xC3", "\xE2\x82", "\xF0\x9F\x98"};
+
+    auto previous = scan::isa();
+    for (auto isa: {scan::SCALAR, scan::SSE2, scan::AVX2}) {
+        scan::select(isa);
+        REQUIRE(scan::utf8(text.data(), text.data() + text.size()) == text.data() + text.size());
+        for (std::size_t at = 0; at <= text.size(); at++) {
+            // only insert at character boundaries
+            if ((std::uint8_t(text[at]) & 0xC0) == 0x80) continue;
+            for (auto b: bad) {
+                auto broken = text.substr(0, at) + b + text.substr(at);
+                auto found = scan::utf8(broken.data(), broken.data() + broken.size());
+                REQUIRE(std::size_t(found - broken.data()) == at);
+            }
+        }
+    }
+    scan::select(previous);
+}
+#endif
@@ -0,0 +1,270 @@
+//
+// Created by Mpho Mbotho on 2021-08-24.
+//
+
+#include "source.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    class FileDescriptor {
+    public:
+        explicit FileDescriptor(int fd) : mFd{fd} {}
+        ~FileDescriptor() { if (mFd >= 0) ::close(mFd); }
+        operator int() const { return mFd; }
+    private:
+        int mFd{-1};
+    };
+
+    template <typename... Args>
+    cyntactic::Exception ioError(const std::string& name, Args&&... args)
+    {
+        std::stringstream ss;
+        ss << name << ": error(io): ";
+        (ss << ... << args);
+        ss << ", " << strerror(errno);
+        return cyntactic::Exception(ss.str());
+    }
+}
+
+namespace cyntactic {
+
+    SourceBuffer::Ptr SourceBuffer::open(const std::filesystem::path& path)
+    {
+        std::shared_ptr<SourceBuffer> buffer{new SourceBuffer(path.string())};
+        FileDescriptor fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (fd < 0) {
+            throw ioError(buffer->mName, "unable to open source file");
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) < 0) {
+            throw ioError(buffer->mName, "unable to stat source file");
+        }
+
+        if (S_ISREG(st.st_mode) && st.st_size > 0) {
+            // reserve zeroed pages for the file and its padding, then map the
+            // file over them: reading past the end of a file mapping would fault
+            auto size = std::size_t(st.st_size);
+            auto page = std::size_t(::sysconf(_SC_PAGESIZE));
+            auto total = (size + Padding + page - 1) / page * page;
+            auto *base = ::mmap(nullptr, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base != MAP_FAILED) {
+                auto *data = ::mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+                if (data != MAP_FAILED) {
+                    ::madvise(data, size, MADV_SEQUENTIAL);
+                    buffer->mData = static_cast<const char *>(data);
+                    buffer->mSize = size;
+                    buffer->mMapSize = total;
+                    buffer->mMapped = true;
+                    return buffer;
+                }
+                ::munmap(base, total);
+            }
+        }
+
+        // pipes, devices and files that cannot be mapped are read in chunks
+        auto& storage = buffer->mStorage;
+        if (S_ISREG(st.st_mode)) {
+            storage.reserve(std::size_t(st.st_size));
+        }
+        constexpr std::size_t Chunk = 64 * 1024;
+        std::size_t used{0};
+        do {
+            storage.resize(used + Chunk);
+            auto n = ::read(fd, storage.data() + used, Chunk);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw ioError(buffer->mName, "unable to read source file");
+            }
+            if (n == 0) break;
+            used += std::size_t(n);
+        } while (true);
+        storage.resize(used);
+        storage.append(Padding, '\0');
+
+        buffer->mData = storage.data();
+        buffer->mSize = used;
+        return buffer;
+    }
+
+    SourceBuffer::Ptr SourceBuffer::copy(std::string_view code, std::string name)
+    {
+        std::shared_ptr<SourceBuffer> buffer{new SourceBuffer(std::move(name))};
+        auto& storage = buffer->mStorage;
+        storage.reserve(code.size() + Padding);
+        storage.append(code);
+        storage.append(Padding, '\0');
+        buffer->mData = storage.data();
+        buffer->mSize = code.size();
+        return buffer;
+    }
+
+    SourceBuffer::Ptr SourceBuffer::view(std::string_view code, std::string name)
+    {
+        std::shared_ptr<SourceBuffer> buffer{new SourceBuffer(std::move(name))};
+        buffer->mData = code.data();
+        buffer->mSize = code.size();
+        buffer->mPadded = false;
+        return buffer;
+    }
+
+    SourceBuffer::~SourceBuffer()
+    {
+        if (mMapped) {
+            ::munmap(const_cast<char *>(mData), mMapSize);
+        }
+    }
+}
+
+namespace cyntactic {
+
+    SourceLoc SourceManager::add(SourceBuffer::Ptr buffer)
+    {
+        std::lock_guard<std::mutex> lock{mLock};
+        auto size = buffer->code().size() + 1;
+        if (size > UINT32_MAX - mNext) {
+            throw Exception("source '" + buffer->name() + "' does not fit in the 32-bit location space");
+        }
+        SourceLoc base{mNext};
+        mFiles.push_back({mNext, std::move(buffer)});
+        mNext += std::uint32_t(size);
+        return base;
+    }
+
+    SourceManager::File* SourceManager::file(SourceLoc loc) const
+    {
+        auto it = std::upper_bound(mFiles.begin(), mFiles.end(), loc.Raw,
+                                   [](std::uint32_t raw, const File& f) { return raw < f.Base; });
+        if (!loc || it == mFiles.begin()) {
+            return nullptr;
+        }
+        --it;
+        if (loc.Raw - it->Base > it->Buffer->code().size()) {
+            return nullptr;
+        }
+        return &*it;
+    }
+
+    std::pair<const SourceBuffer*, std::size_t> SourceManager::find(SourceLoc loc) const
+    {
+        std::lock_guard<std::mutex> lock{mLock};
+        const auto *f = file(loc);
+        if (f == nullptr) {
+            return {nullptr, 0};
+        }
+        return {f->Buffer.get(), loc.Raw - f->Base};
+    }
+
+    SourceManager::Location SourceManager::decode(SourceLoc loc) const
+    {
+        std::lock_guard<std::mutex> lock{mLock};
+        auto *f = file(loc);
+        if (f == nullptr) {
+            return {};
+        }
+        if (f->Lines.empty()) {
+            f->Lines = LineIndex{f->Buffer->code()};
+        }
+        auto [line, column] = f->Lines.location(loc.Raw - f->Base);
+        return {f->Buffer->name(), line, column};
+    }
+
+    std::size_t SourceManager::files() const
+    {
+        std::lock_guard<std::mutex> lock{mLock};
+        return mFiles.size();
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+TEST_CASE("SourceBuffer maps regular files and reads everything else", "[source]")
+{
+    using cyntactic::SourceBuffer;
+    auto path = std::filesystem::temp_directory_path() / "cyntactic-source-test.cyn";
+    std::ofstream{path} << "import sys;\n";
+
+    auto padded = [](const SourceBuffer& buffer) {
+        const auto *end = buffer.code().data() + buffer.code().size();
+        return std::all_of(end, end + SourceBuffer::Padding, [](char c) { return c == '\0'; });
+    };
+
+    auto mapped = SourceBuffer::open(path);
+    CHECK(mapped->mapped());
+    CHECK(mapped->code() == "import sys;\n");
+    CHECK(mapped->name() == path.string());
+    CHECK(padded(*mapped));
+
+    // a file filling whole pages still gets its padding
+    std::ofstream{path, std::ios::trunc} << std::string(2 * ::sysconf(_SC_PAGESIZE), 'a');
+    auto pages = SourceBuffer::open(path);
+    CHECK(pages->mapped());
+    CHECK(pages->code().size() == 2 * std::size_t(::sysconf(_SC_PAGESIZE)));
+    CHECK(padded(*pages));
+
+    auto copied = SourceBuffer::copy("x + 1;", "<copy>");
+    CHECK(copied->code() == "x + 1;");
+    CHECK(padded(*copied));
+    CHECK(copied->padded());
+
+    std::string owned{"x + 1;"};
+    auto viewed = SourceBuffer::view(owned, "<view>");
+    CHECK(viewed->code().data() == owned.data());
+    CHECK(viewed->code().size() == owned.size());
+    CHECK_FALSE(viewed->padded());
+
+    std::ofstream{path, std::ios::trunc};
+    auto empty = SourceBuffer::open(path);
+    CHECK_FALSE(empty->mapped());
+    CHECK(empty->code().empty());
+    CHECK(padded(*empty));
+    std::filesystem::remove(path);
+
+    CHECK_THROWS_AS(SourceBuffer::open(path), cyntactic::Exception);
+}
+TEST_CASE("Source locations decode to the file, line and column they came from", "[source]")
+{
+    using namespace cyntactic;
+    SourceManager sources;
+    auto first = sources.add(SourceBuffer::copy("a\nbc\n", "first.cyn"));
+    auto second = sources.add(SourceBuffer::copy("", "empty.cyn"));
+    auto third = sources.add(SourceBuffer::copy("x\n\n  y", "third.cyn"));
+    CHECK(sources.files() == 3);
+    CHECK(first.Raw == 1);
+    CHECK(second.Raw == first.Raw + 6);
+    CHECK(third.Raw == second.Raw + 1);
+
+    auto check = [&](SourceLoc loc, std::string_view file, std::size_t line, std::size_t column) {
+        auto decoded = sources.decode(loc);
+        CHECK(decoded.File == file);
+        CHECK(decoded.Line == line);
+        CHECK(decoded.Column == column);
+    };
+    check(first, "first.cyn", 1, 1);
+    check(first + 3, "first.cyn", 2, 2);
+    // the end of a file has a location of its own
+    check(first + 5, "first.cyn", 3, 1);
+    check(second, "empty.cyn", 1, 1);
+    check(third + 5, "third.cyn", 3, 3);
+    check(SourceLoc{}, "", 0, 0);
+    check(third + 7, "", 0, 0);
+
+    auto [buffer, offset] = sources.find(third + 5);
+    REQUIRE(buffer != nullptr);
+    CHECK(buffer->code()[offset] == 'y');
+}
+#endif
@@ -0,0 +1,160 @@
+//
+// Created by Mpho Mbotho on 2021-08-24.
+//
+
+#include "stream.hpp"
+#include "exceptions.hpp"
+#include "scanner.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace {
+    /*
+     * A token (or an error) that close to the end of the window might turn
+     * out differently once more input is available.
+     */
+    constexpr std::size_t Lookahead = cyntactic::Tokenizer::Lookahead;
+}
+
+namespace cyntactic {
+
+    std::size_t FdChunkSource::read(char *buf, std::size_t size)
+    {
+        do {
+            auto n = ::read(mFd, buf, size);
+            if (n >= 0) {
+                return std::size_t(n);
+            }
+            if (errno != EINTR) {
+                throw Exception(mName + ": error(io): read failed, " + strerror(errno));
+            }
+        } while (true);
+    }
+
+    std::size_t ViewChunkSource::read(char *buf, std::size_t size)
+    {
+        auto n = std::min({size, mChunk, mData.size()});
+        memcpy(buf, mData.data(), n);
+        mData.remove_prefix(n);
+        return n;
+    }
+
+    StreamTokenizer::StreamTokenizer(ChunkSource& source, std::string_view name, std::size_t chunk)
+        : mSource{source},
+          mName{name},
+          mChunk{std::max(chunk, Lookahead + 1)}
+    {
+        mWindow.resize(mChunk);
+        mTokenizer.reset({mWindow.data(), 0}, mName);
+    }
+
+    void StreamTokenizer::refill(std::size_t keep)
+    {
+        // advance the origin over the bytes that are dropped from the window
+        const auto *begin = mWindow.data(), *end = begin + keep;
+        if (auto lines = scan::count(begin, end, '\n')) {
+            const auto *nl = end;
+            while (*--nl != '\n');
+            mOrigin = {mOrigin.first + lines, std::size_t(end - nl)};
+        }
+        else {
+            mOrigin.second += keep;
+        }
+
+        auto remaining = mSize - keep;
+        memmove(mWindow.data(), mWindow.data() + keep, remaining);
+        mBase += keep;
+        mSize = remaining;
+        if (mWindow.size() < mSize + mChunk) {
+            // only ever grows to hold a token longer than the window, doubling
+            // so that such a token is relexed a logarithmic number of times
+            mWindow.resize(std::max(2 * mSize, mSize + mChunk));
+        }
+
+        // a token that did not fit a chunk is only relexed once the window
+        // is full again, whatever the size of the source's reads
+        const auto wait = mSize > mChunk;
+        std::size_t n{0};
+        do {
+            n = mSource.read(mWindow.data() + mSize, mWindow.size() - mSize);
+            mSize += n;
+        } while (wait && n != 0 && mSize < mWindow.size());
+        mEof = (n == 0);
+        mRefills++;
+        mTokenizer.reset({mWindow.data(), mSize}, mName, mOrigin);
+    }
+
+    Token StreamTokenizer::next()
+    {
+        do {
+            auto start = mTokenizer.offset();
+            try {
+                auto tok = mTokenizer.next();
+                if (mEof || mTokenizer.offset() + Lookahead < mSize) {
+                    mLast = mBase + (tok.Value.data() - mWindow.data());
+                    return tok;
+                }
+            }
+            catch (SyntaxError&) {
+                // errors far from the end of the window cannot be caused by it
+                if (mEof || mTokenizer.offset() + Lookahead < mSize) {
+                    throw;
+                }
+            }
+            refill(start);
+        } while (true);
+    }
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("StreamTokenizer matches the whole buffer tokenizer at any chunk size", "[stream]")
+{
+    using namespace cyntactic;
+    std::string code{"import a.{b, c}; /* spans\n a chunk */ x <<= 0x1F ...y;\n"
+                     "\"a long string literal \\\" that crosses chunks\" // tail\n'\\n' >>= z"};
+    code += std::string(200, ' ') + "long_identifier_at_the_end";
+    auto expected = Tokenizer{code}.tokenizeAll();
+
+    for (std::size_t chunk: {1, 2, 3, 5, 8, 13, 64}) {
+        ViewChunkSource source{code, chunk};
+        StreamTokenizer stream{source, "<test>", chunk};
+        for (std::size_t i = 0; i < expected.size(); i++) {
+            auto tok = stream.next();
+            REQUIRE(tok.kind == expected.kind(i));
+            REQUIRE(tok.Value == expected.value(i));
+            REQUIRE(stream.offset() == expected.Offsets[i]);
+        }
+        // the window never needs more than the chunk size plus twice the longest token
+        CHECK(stream.capacity() <= std::max<std::size_t>(chunk, 4) + 2 * (200 + Lookahead));
+    }
+
+    // a token many chunks long is not relexed after every chunk
+    std::string huge = "x " + std::string(100000, 'a') + " y";
+    ViewChunkSource source{huge, 16};
+    StreamTokenizer longest{source, "<test>", 16};
+    std::vector<std::size_t> sizes;
+    for (auto tok = longest.next(); tok.kind != Token::T_EOF; tok = longest.next()) {
+        sizes.push_back(tok.Value.size());
+    }
+    CHECK(sizes == std::vector<std::size_t>{1, 1, 100000, 1, 1});
+    CHECK(longest.refills() < 32);
+    CHECK(longest.capacity() <= 4 * 100000);
+
+    ViewChunkSource broken{"a + /* never closed", 4};
+    StreamTokenizer stream{broken, "<test>", 4};
+    CHECK(stream.next().Value == "a");
+    try {
+        while (stream.next().kind != Token::T_EOF);
+        FAIL("expected a syntax error");
+    }
+    catch (SyntaxError& ex) {
+        CHECK(std::string{ex.what()}.find("<test>:1:20") == 0);
+    }
+}
+#endif
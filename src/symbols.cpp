@@ -7,64 +7,67 @@
 
 namespace cyntactic {
 
-    std::stack<SymTable> gScopes;
-    SymTable &SymTable::get()
+    SymTable::SymTable()
     {
-        static bool initialized{false};
-        if (!initialized) {
-            gScopes.push({});
-            initialized = true;
-        }
-        return gScopes.top();
+        mScopes.emplace_back();
     }
 
     void SymTable::push()
     {
-        gScopes.push({&get()});
+        mScopes.emplace_back();
     }
 
     void SymTable::pop()
     {
-        if (gScopes.size() == 1) {
+        if (mScopes.size() == 1) {
             throw Exception("Cannot pop the global symbol table");
         }
-        gScopes.pop();
+        mScopes.pop_back();
     }
 
     bool SymTable::add(Symbol::Ptr &&sym)
     {
-        auto& table = get();
-        auto it = table.mSymbols.find(sym->Name);
-        if (it == table.mSymbols.end()) {
-            return false;
-        }
-        table.mSymbols.emplace(sym->Name, std::move(sym));
-        return true;
+        auto id = sym->Name;
+        return mScopes.back().emplace(id, std::move(sym)).second;
     }
 
-    Symbol::Ptr SymTable::get(const std::string_view& name)
+    Symbol::Ptr SymTable::get(Interner::Id name) const
     {
-        auto& table = get();
-        auto it = table.mSymbols.find(name);
-        if (it == table.mSymbols.end()) {
-            if (table.mParent != nullptr) {
-                return table.mParent->get(name);
+        for (auto it = mScopes.rbegin(); it != mScopes.rend(); it++) {
+            auto sym = it->find(name);
+            if (sym != it->end()) {
+                return sym->second;
             }
-            return nullptr;
         }
-        return it->second;
+        return nullptr;
     }
 
-    bool SymTable::isDefined(const std::string_view &name)
+    bool SymTable::isDefined(Interner::Id name) const
     {
-        auto& table = get();
-        auto it = table.mSymbols.find(name);
-        if (it == table.mSymbols.end()) {
-            if (table.mParent != nullptr) {
-                return table.mParent->isDefined(name);
-            }
-            return false;
-        }
-        return true;
+        return get(name) != nullptr;
     }
-}
\ No newline at end of file
+}
+
+#ifdef SYNTATIC_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("Symbols are looked up from the innermost scope out", "[symbols]")
+{
+    using namespace cyntactic;
+    Interner names;
+    auto x = names.intern("x"), y = names.intern("y");
+    SymTable table;
+    CHECK(table.add(std::make_shared<Symbol>(Symbol{Symbol::S_IDENT, x})));
+    CHECK_FALSE(table.add(std::make_shared<Symbol>(Symbol{Symbol::S_TYPE, x})));
+    table.push();
+    CHECK(table.add(std::make_shared<Symbol>(Symbol{Symbol::S_FUNC, y})));
+    CHECK(table.get(x)->kind == Symbol::S_IDENT);
+    CHECK(table.isDefined(y));
+    table.pop();
+    CHECK_FALSE(table.isDefined(y));
+    CHECK_THROWS_AS(table.pop(), Exception);
+
+    // every table has scopes of its own
+    CHECK_FALSE(SymTable{}.isDefined(x));
+}
+#endif
@@ -1,18 +1,59 @@
 #include "tokenizer.hpp"
 #include "exceptions.hpp"
+#include "lexspec.hpp"
+#include "scanner.hpp"
+#include "unicode.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <thread>
 #include <vector>
 #include <utility>
 
 namespace {
+    using cyntactic::Token;
+
+    // the number of bytes in front of a token's value that belong to the token
+    std::size_t opening(Token::Kind kind)
+    {
+        switch (kind) {
+            case Token::STRING:
+            case Token::CHAR_LITERAL: return 1;
+            case Token::COMMENT: return 2;
+            default: return 0;
+        }
+    }
+
+    template <typename T>
+    void splice(std::vector<T>& into, std::size_t first, std::size_t last, const std::vector<T>& from)
+    {
+        // overwrite what can be, so equal sized replacements never move the tail
+        auto common = std::min(last - first, from.size());
+        std::copy_n(from.begin(), common, into.begin() + first);
+        if (common < from.size()) {
+            into.insert(into.begin() + first + common, from.begin() + common, from.end());
+        }
+        else {
+            into.erase(into.begin() + first + common, into.begin() + last);
+        }
+    }
+
     std::string_view charString(char c)
     {
-        static char buf[10];
-        if (c == EOF) {
+        // errors are formatted by the workers of a parallel tokenizeAll() too
+        thread_local char buf[10];
+        if (c == '\0') {
+            // the sentinel read past the end of the code
             return "EOF";
         }
-        if (!isprint(c)) {
-            size_t count = sprintf(buf, "ascii-%02X", c);
+        auto u = std::uint8_t(c);
+        if (u >= 0x80) {
+            // part of a multi byte character, which cannot be printed on its own
+            size_t count = sprintf(buf, "0x%02X", u);
+            return {buf, count};
+        }
+        if (!isprint(u)) {
+            size_t count = sprintf(buf, "ascii-%02X", u);
             return {buf, count};
         }
         else {
@@ -20,209 +61,304 @@ namespace {
             return {buf, count};
         }
     }
-
-    inline bool ishex(char c)
-    {
-        return (c >= '0' and c <= '9') ||
-               (c >= 'a' and c <= 'f') ||
-               (c >= 'A' and c <= 'F');
-    }
 }
 
 namespace cyntactic {
 
-using escapable = any_of<char, 'b', 'f', 'n', 'r', 't', 'v', '\\', '\'', '"', '?', '0'>;
-std::string_view escaped(char c)
-{
-    const std::unordered_map<char, std::string_view> ESCAPABLE = {
-        {'b',  "\b"},
-        {'f',  "\f"},
-        {'n',  "\n"},
-        {'r',  "\r"},
-        {'t',  "\t"},
-        {'v',  "\v"},
-        {'\\', "\\"},
-        {'\'', "\'"},
-        {'"',  "\""},
-        {'?',  "\?"},
-        {'0',  "\0"}
-    };
-    auto it = ESCAPABLE.find(c);
-    if (it != ESCAPABLE.end()) {
-        return it->second;
-    }
-    return {};
+void Tokenizer::reset(const SourceBuffer& source)
+{
+    reset(source.code(), source.name());
+    mPadded = source.padded();
 }
 
 void Tokenizer::reset(std::string_view code, const std::string_view& src)
 {
     mSource = src;
     mCode = code;
-    mLine = 1;
+    mPadded = false;
     mPos = 0;
-    mCol = 1;
+    mValid = 0;
+    mLines = {};
+    mOrigin = {1, 1};
+    mCollected.clear();
+    mSignificant = 0;
 }
 
-std::tuple<char, char, char> Tokenizer::peekThree() const
+void Tokenizer::reset(std::string_view code, const std::string_view& src, Location origin)
 {
-    auto i = mPos;
-    auto ii = i + 1;
-    auto iii = ii + 1;
+    reset(code, src);
+    mOrigin = origin;
+}
 
+/*
+ * Reading past the end of the code yields the NUL sentinel. Padded code
+ * really is followed by NUL bytes, so the padded peeks load without checking.
+ */
+template <bool Padded>
+std::tuple<char, char, char> Tokenizer::peekThree() const
+{
+    const auto *p = mCode.data() + mPos;
+    if constexpr (Padded) {
+        return {p[0], p[1], p[2]};
+    }
+    auto left = mCode.size() - mPos;
     return {
-        ((i   < mCode.size())? mCode[i]:  char(EOF)),
-        ((ii  < mCode.size())? mCode[ii]:  char(EOF)),
-        ((iii < mCode.size())? mCode[iii]: char(EOF))
+        ((left > 0)? p[0] : '\0'),
+        ((left > 1)? p[1] : '\0'),
+        ((left > 2)? p[2] : '\0')
     };
 }
 
+template <bool Padded>
 std::pair<char, char> Tokenizer::peekTwo() const
 {
-    auto i  = mPos;
-    auto ii = i + 1;
+    const auto *p = mCode.data() + mPos;
+    if constexpr (Padded) {
+        return {p[0], p[1]};
+    }
+    auto left = mCode.size() - mPos;
     return {
-        ((i   < mCode.size())? mCode[i]:  char(EOF)),
-        ((ii  < mCode.size())? mCode[ii]:  char(EOF))
+        ((left > 0)? p[0] : '\0'),
+        ((left > 1)? p[1] : '\0')
     };
 }
 
+template <bool Padded>
 char Tokenizer::peek() const
 {
-    return (mPos < mCode.size())? mCode[mPos] : char(EOF);
+    if constexpr (Padded) {
+        return mCode.data()[mPos];
+    }
+    return (mPos < mCode.size())? mCode[mPos] : '\0';
 }
 
+template <bool Padded>
 Token Tokenizer::tok(Token&& tok, unsigned c)
 {
-    eat(c);
+    eat<Padded>(c);
     return tok;
 }
 
+template <bool Padded>
 void Tokenizer::eat(unsigned c)
 {
-    for (auto i = 0; i < c; i++, mPos++) {
-        if (mPos >= mCode.size()) break;
-        if (mCode[mPos] == '\n') {
-            mLine++;
-            mCol = 0;
-        }
-        else {
-            mCol++;
-        }
+    // the lexer never eats a sentinel it has not checked, except for errors
+    if constexpr (Padded) {
+        mPos += c;
+    }
+    else {
+        mPos = std::min(mPos + c, mCode.size());
     }
 }
 
+void Tokenizer::skip(const char *to)
+{
+    mPos = to - mCode.data();
+}
+
 void Tokenizer::eatWhiteSpace()
 {
-    while (isspace(peek()))
-        eat();
+    skip(scan::whitespace(mCode.data() + mPos, mCode.data() + mCode.size()));
+}
+
+template <typename... Args>
+Token Tokenizer::fail(Token::Error error, std::size_t start, char until, Args&&... args)
+{
+    mPos = std::min(mPos, mCode.size());
+    if (!mRecover) {
+        throw SyntaxError(mSource, line(), column(), std::forward<Args>(args)...);
+    }
+    if (until != '\0') {
+        // drop the rest of the broken literal, up to its closing quote on the same line,
+        // an escaped quote does not close it
+        const auto *end = mCode.data() + mCode.size();
+        const auto *eol = scan::find(mCode.data() + mPos, end, '\n');
+        const auto *p = mCode.data() + mPos;
+        while (p < eol && *p != until) {
+            p += (*p == '\\' && p + 1 < eol)? 2 : 1;
+        }
+        skip((p < eol)? p + 1 : eol);
+    }
+    return {Token::ERROR, mCode.substr(start, mPos - start), Interner::Id(error)};
 }
 
+template <bool Padded>
 Token Tokenizer::parseCharacter()
 {
-    auto [c, cc, ccc] = peekThree();
+    auto start = mPos - 1;
+    auto [c, cc, ccc] = peekThree<Padded>();
     auto val = mCode.substr(mPos, 1);
 
     if (c == '\\') {
-        eat(); // eat the escape
-        if (escapable{}(cc)) {
-            val = escaped(cc);
+        eat<Padded>(); // eat the escape
+        if (lex::is(cc, lex::F_ESCAPABLE)) {
+            // the value is the raw escape sequence, decoded by the parser
+            val = mCode.substr(mPos - 1, 2);
             cc = ccc;
         }
         else {
-            throw SyntaxError(mSource, mLine, mCol,
+            return fail(Token::E_CHAR_ESCAPE, start, '\'',
                     "character escape '\\", charString(cc), "' is not supported");
         }
     }
 
     if (cc != '\'') {
-        eat(); // eat the character
-        throw SyntaxError(mSource, mLine, mCol, "unexpected character '", charString(cc), "', expecting a \"'\"");
+        eat<Padded>(); // eat the character
+        return fail(Token::E_UNTERMINATED_CHAR, start, '\'',
+                "unexpected character '", charString(cc), "', expecting a \"'\"");
     }
-    return tok({Token::CHAR_LITERAL, val}, 2);
+    eat<Padded>(2);
+    return text(start, {Token::CHAR_LITERAL, val});
 }
 
 Token Tokenizer::parseIdentifier()
 {
+    // the lead was checked by the caller, a non-ASCII one is a whole well formed sequence
     auto start = mPos;
-    eat();
+    const auto *end = mCode.data() + mCode.size();
+    const auto *p = mCode.data() + mPos;
+    p += (std::uint8_t(*p) < 0x80)? 1 : utf8::sequence(p, end);
     do {
-        auto c = peek();
-        if (isalnum(c) || c == '_') {
-            eat();
+        p = scan::identifier(p, end);
+        if (p == end || std::uint8_t(*p) < 0x80) {
+            break;
         }
-        else {
+        auto n = utf8::sequence(p, end);
+        if (n == 0 || !utf8::isXidContinue(utf8::decode(p, n))) {
             break;
         }
-    } while(true);
+        p += n;
+    } while (true);
+    mPos = p - mCode.data();
 
     auto var = mCode.substr(start, (mPos - start));
-    auto it = Keywords.find(var);
-    if (it != Keywords.end()) {
-        return {it->second, it->first};
+    auto kind = lex::keyword(var);
+    if (kind == Token::IDENTIFIER && mNames != nullptr) {
+        return {kind, var, mNames->intern(var)};
+    }
+    return {kind, var};
+}
+
+Token Tokenizer::parseUnicode()
+{
+    // only well formed sequences are looked up in the identifier tables
+    const auto *p = mCode.data() + mPos;
+    auto n = utf8::sequence(p, mCode.data() + mCode.size());
+    if (n == 0) {
+        mPos++;
+        return fail(Token::E_INVALID_UTF8, mPos - 1, '\0',
+            "invalid UTF-8 sequence at byte ", charString(*p));
     }
-    return {Token::IDENTIFIER, var};
+    if (utf8::isXidStart(utf8::decode(p, n))) {
+        return parseIdentifier();
+    }
+    mPos += n;
+    return fail(Token::E_UNEXPECTED_CHAR, mPos - n, '\0',
+        "Unexpected '", mCode.substr(mPos - n, n), "'");
 }
 
+template <bool Padded>
 Token Tokenizer::parseString()
 {
     auto start = mPos;
     do {
-        auto [c, cc] = peekTwo();
+        auto [c, cc] = peekTwo<Padded>();
         if (c == '\\') {
-            if (escapable{}(cc) || cc == '$') {
-                eat(2);
+            if (lex::is(cc, lex::F_ESCAPABLE) || cc == '$') {
+                eat<Padded>(2);
             }
             else {
-                throw SyntaxError(mSource, mLine, mCol,
+                return fail(Token::E_STRING_ESCAPE, start - 1, '"',
                           "unexpected escaped character, '", charString(cc), "'");
             }
         }
         else if (c == '$' and cc == '{') {
             // return whatever we have so far, it's part of a string expression
-            return {Token::STRING, mCode.substr(start, mPos-start)};
+            return text(start - 1, {Token::STRING, mCode.substr(start, mPos-start)});
         }
         else if (c == '"') {
             // end of string found
             break;
         }
+        else if (c == '\0' && mPos >= mCode.size()) {
+            return fail(Token::E_UNTERMINATED_STRING, start - 1, '\0',
+                      "unterminated string, EOF before closing '\"'");
+        }
         else {
-            eat();
+            eat<Padded>();
         }
     } while (true);
 
-    return {Token::STRING, mCode.substr(start, mPos-start)};
+    auto value = mCode.substr(start, mPos-start);
+    eat<Padded>();
+    return text(start - 1, {Token::STRING, value});
 }
 
+template <bool Padded>
 Token Tokenizer::parseHexNumber()
 {
     auto start = mPos;
-    eat(2);
+    eat<Padded>(2);
     do {
-        auto c = peek();
-        if (ishex(c)) {
-            eat();
+        auto c = peek<Padded>();
+        if (lex::is(c, lex::F_HEX)) {
+            eat<Padded>();
         }
         else {
             break;
         }
     } while(true);
 
-    auto c = peek();
-    if (any_of<char, '.','p','P'>{}(c)) {
-        return parseHexFloat(start);
+    auto [c, cc] = peekTwo<Padded>();
+    if ((c == '.' && (lex::is(cc, lex::F_HEX) || cc == 'p' || cc == 'P')) || c == 'p' || c == 'P') {
+        return parseHexFloat<Padded>(start);
     }
 
     return {Token::HEX_LITERAL, mCode.substr(start, mPos-start)};
 }
 
+template <bool Padded>
+Token Tokenizer::parseHexFloat(std::size_t start)
+{
+    // 0x<hex digits>[.<hex digits>]p[+-]<digits>, the binary exponent is mandatory
+    if (peek<Padded>() == '.') {
+        eat<Padded>();
+        while (lex::is(peek<Padded>(), lex::F_HEX)) eat<Padded>();
+    }
+    auto c = peek<Padded>();
+    if (c != 'p' && c != 'P') {
+        return fail(Token::E_HEX_FLOAT_EXPONENT, start, '\0',
+                  "hexadecimal floating point literal requires a binary exponent ('p')");
+    }
+    if (!parseExponent<Padded>()) {
+        return fail(Token::E_EXPONENT_DIGITS, start, '\0',
+                  "exponent of floating point literal has no digits");
+    }
+    return {Token::FLOAT_LITERAL, mCode.substr(start, mPos-start)};
+}
+
+template <bool Padded>
+bool Tokenizer::parseExponent()
+{
+    // at 'e', 'E', 'p' or 'P', followed by an optionally signed decimal
+    auto cc = peekTwo<Padded>().second;
+    eat<Padded>((cc == '+' || cc == '-')? 2 : 1);
+    if (!lex::is(peek<Padded>(), lex::F_DIGIT)) {
+        return false;
+    }
+    while (lex::is(peek<Padded>(), lex::F_DIGIT)) eat<Padded>();
+    return true;
+}
+
+template <bool Padded>
 Token Tokenizer::parseOctalNumber()
 {
     auto start = mPos;
-    eat();
+    eat<Padded>();
     do {
-        auto c = peek();
-        if (c >= '0' && c <= '7') {
-            eat();
+        auto c = peek<Padded>();
+        if (lex::is(c, lex::F_OCTAL)) {
+            eat<Padded>();
         }
         else {
             break;
@@ -232,14 +368,15 @@ Token Tokenizer::parseOctalNumber()
     return {Token::OCT_LITERAL, mCode.substr(start, mPos-start)};
 }
 
+template <bool Padded>
 Token Tokenizer::parseBinaryNumber()
 {
     auto start = mPos;
-    eat(2);
+    eat<Padded>(2);
     do {
-        auto c = peek();
+        auto c = peek<Padded>();
         if (c == '0' || c == '1') {
-            eat();
+            eat<Padded>();
         }
         else {
             break;
@@ -249,241 +386,624 @@ Token Tokenizer::parseBinaryNumber()
     return {Token::BIN_LITERAL, mCode.substr(start, mPos-start)};
 }
 
+template <bool Padded>
 Token Tokenizer::parseDecimalNumber()
 {
     auto start = mPos;
-    eat();
+    eat<Padded>();
     do {
-        auto c = peek();
-        if (isdigit(c)) {
-            eat();
+        auto c = peek<Padded>();
+        if (lex::is(c, lex::F_DIGIT)) {
+            eat<Padded>();
         }
         else {
             break;
         }
     } while(true);
 
-    auto c = peek();
-    if (any_of<char, '.', 'e', 'E'>{}(c)) {
-        return parseDecimalFloat(start);
+    // 1..2 is a sequence and 1.x a member access, only 1.2 continues as a float
+    auto [c, cc] = peekTwo<Padded>();
+    if ((c == '.' && lex::is(cc, lex::F_DIGIT)) || c == 'e' || c == 'E') {
+        return parseDecimalFloat<Padded>(start);
     }
 
     return {Token::DEC_LITERAL, mCode.substr(start, mPos-start)};
 }
 
+template <bool Padded>
+Token Tokenizer::parseDecimalFloat(std::size_t start)
+{
+    // <digits>[.<digits>][e[+-]<digits>]
+    if (peek<Padded>() == '.') {
+        eat<Padded>();
+        while (lex::is(peek<Padded>(), lex::F_DIGIT)) eat<Padded>();
+    }
+    auto c = peek<Padded>();
+    if ((c == 'e' || c == 'E') && !parseExponent<Padded>()) {
+        return fail(Token::E_EXPONENT_DIGITS, start, '\0',
+                  "exponent of floating point literal has no digits");
+    }
+    return {Token::FLOAT_LITERAL, mCode.substr(start, mPos-start)};
+}
+
+template <bool Padded>
 Token Tokenizer::parseMultiLineComment()
 {
     auto start = mPos;
+    const auto *end = mCode.data() + mCode.size();
+    const auto *p = mCode.data() + mPos;
     do {
-        auto [c, cc] = peekTwo();
-        if (c == EOF) {
-            throw SyntaxError(mSource, mLine, mCol,
+        p = scan::find(p, end, '*');
+        if (p + 1 >= end) {
+            skip(end);
+            return fail(Token::E_UNTERMINATED_COMMENT, start - 2, '\0',
                       "unterminated multiline comment, EOF before */");
         }
-
-        if (c  == '*' and cc == '/') {
+        if (p[1] == '/') {
             break;
         }
-        else {
-            eat();
-        }
+        p++;
     } while (true);
 
-    return tok({Token::COMMENT, mCode.substr(start, mPos-start)}, 2);
+    skip(p);
+    auto comment = mCode.substr(start, mPos-start);
+    eat<Padded>(2);
+    return text(start - 2, {Token::COMMENT, comment});
 }
 
 Token Tokenizer::parseSingleLineComment()
 {
     auto start = mPos;
-    while(peek() != '\n') eat();
-    return tok({Token::COMMENT, mCode.substr(start, mPos-start)});
+    const auto *end = mCode.data() + mCode.size();
+    const auto *p = scan::find(mCode.data() + mPos, end, '\n');
+    skip(p);
+    auto comment = mCode.substr(start, mPos-start);
+    skip(std::min(p + 1, end));
+    return text(start - 2, {Token::COMMENT, comment});
 }
 
 
-Token Tokenizer::next()
+Tokenizer::Location Tokenizer::location(std::size_t offset) const
 {
-    auto [c, cc, ccc] = peekThree();
-    if (c == EOF) {
-        return {};
-    }
-
-    switch(c) {
-        case '@': return tok({Token::COMPTIME});
-        case '{': return tok({Token::LBRACE});
-        case '}': return tok({Token::RBRACE});
-        case '(': return tok({Token::LPAREN});
-        case ')': return tok({Token::RPAREN});
-        case '[': return tok({Token::LBRACKET});
-        case ']': return tok({Token::RBRACKET});
-        case ',': return tok({Token::COMMA});
-        case ';': return tok({Token::SEMICOLON});
-        case '?': return tok({Token::QUESTION});
-        case '`': return tok({Token::GRAVE});
-        case '=': {
-            if (cc ==  '=') {
-                return tok({Token::OP_EQ}, 2);
-            }
-            else {
-                return tok({Token::OP_EQ});
+    if (mLines.empty()) {
+        mLines = LineIndex{mCode};
+    }
+    auto [line, column] = mLines.location(std::min(offset, mCode.size()));
+    if (line == 1) {
+        column += mOrigin.second - 1;
+    }
+    return {line + mOrigin.first - 1, column};
+}
+
+void TokenBuffer::reserve(std::size_t n)
+{
+    Kinds.reserve(n);
+    Offsets.reserve(n);
+    Lengths.reserve(n);
+    Ids.reserve(n);
+}
+
+std::pair<const Trivia*, const Trivia*> TokenBuffer::leading(std::size_t i) const
+{
+    auto range = std::equal_range(Leading.begin(), Leading.end(), Trivia{std::uint32_t(i)},
+                                  [](const Trivia& a, const Trivia& b) { return a.Next < b.Next; });
+    return {Leading.data() + (range.first - Leading.begin()),
+            Leading.data() + (range.second - Leading.begin())};
+}
+
+void TokenBuffer::push(const Token& tok)
+{
+    static_assert(Token::ERROR <= 0xFF, "token kinds must fit in a byte");
+    Kinds.push_back(std::uint8_t(tok.kind));
+    Offsets.push_back(std::uint32_t(tok.Value.data() - mCode.data()));
+    Lengths.push_back(std::uint32_t(tok.Value.size()));
+    Ids.push_back(tok.Id);
+}
+
+void TokenBuffer::clear()
+{
+    Kinds.clear();
+    Offsets.clear();
+    Lengths.clear();
+    Ids.clear();
+    Leading.clear();
+    mShiftFrom = 0;
+    mShift = 0;
+}
+
+std::size_t TokenBuffer::start(std::size_t i) const
+{
+    return offset(i) - opening(kind(i));
+}
+
+std::size_t TokenBuffer::end(std::size_t i) const
+{
+    auto end = offset(i) + Lengths[i];
+    switch (kind(i)) {
+        // a string cut short by a string expression has no closing quote
+        case Token::STRING: return end + (end < mCode.size() && mCode[end] == '"');
+        case Token::CHAR_LITERAL: return end + (end < mCode.size() && mCode[end] == '\'');
+        case Token::COMMENT: return end + ((mCode[start(i) + 1] == '*')? 2 : 0);
+        default: return end;
+    }
+}
+
+void TokenBuffer::shift(std::size_t from, std::ptrdiff_t delta)
+{
+    // only the offsets between the pending and the new shift are rewritten,
+    // repeated edits around the same place stay cheap
+    from = std::min(from, size());
+    if (mShift == 0) {
+        mShiftFrom = from;
+    }
+    else if (from >= mShiftFrom) {
+        for (auto i = mShiftFrom; i < from; i++) Offsets[i] = std::uint32_t(Offsets[i] + mShift);
+    }
+    else {
+        // these only move by delta, the pending shift will be applied on top of it
+        for (auto i = from; i < mShiftFrom; i++) Offsets[i] = std::uint32_t(Offsets[i] - mShift);
+    }
+    mShiftFrom = from;
+    mShift += delta;
+}
+
+void TokenBuffer::settle()
+{
+    for (auto i = mShiftFrom; i < size() && mShift != 0; i++) {
+        Offsets[i] = std::uint32_t(Offsets[i] + mShift);
+    }
+    mShiftFrom = 0;
+    mShift = 0;
+}
+
+bool Tokenizer::skipBody()
+{
+    // only what can hide a brace is looked at, everything else is skipped unlexed
+    const auto *p = mCode.data() + mPos;
+    const auto *end = mCode.data() + mCode.size();
+    std::size_t depth{1};
+    while (p < end) {
+        switch (*p++) {
+            case '{':
+                depth++;
+                break;
+            case '}':
+                if (--depth == 0) {
+                    skip(p);
+                    return true;
+                }
+                break;
+            case '"':
+            case '\'': {
+                auto quote = p[-1];
+                while (p < end && *p != quote) {
+                    p += (*p == '\\' && p + 1 < end)? 2 : 1;
+                }
+                if (p < end) {
+                    p++;
+                }
+                break;
             }
+            case '/':
+                if (p < end && *p == '/') {
+                    p = scan::find(p, end, '\n');
+                }
+                else if (p < end && *p == '*') {
+                    do {
+                        p = scan::find(p + 1, end, '*');
+                    } while (p < end && (p + 1 == end || p[1] != '/'));
+                    p = (p < end)? p + 2 : end;
+                }
+                break;
+            default:
+                break;
         }
-        case '!': {
-            if (cc ==  '=') {
-                return tok({Token::OP_NEQ}, 2);
-            }
-            else {
-                return tok({Token::EXCLAMATION});
-            }
+    }
+    return false;
+}
+
+TokenBuffer Tokenizer::tokenizeAll()
+{
+    if (mCode.size() > UINT32_MAX) {
+        throw Exception("source '" + std::string{mSource} + "' is too large to tokenize (> 4GB)");
+    }
+
+    TokenBuffer buffer{mCode};
+    // on average a token (including separating space) spans ~4 bytes
+    buffer.reserve((mCode.size() - mPos) / 4 + 1);
+    mCollected.clear();
+    mSignificant = 0;
+    Token token;
+    do {
+        token = next();
+        buffer.push(token);
+    } while (token.kind != Token::T_EOF);
+    buffer.Leading = std::move(mCollected);
+    mCollected.clear();
+    return buffer;
+}
+
+struct Tokenizer::Chunk {
+    TokenBuffer Tokens;
+    std::vector<std::uint32_t> Starts{};
+    std::size_t Begin{0};
+    std::size_t Exit{0};
+    std::exception_ptr Error{};
+};
+
+void Tokenizer::tokenizeRange(Chunk& chunk, std::size_t from, std::size_t until)
+{
+    // lexes every token starting before `until`, the last one may run past it
+    chunk.Tokens = TokenBuffer{mCode};
+    chunk.Tokens.reserve((until - from) / 4 + 1);
+    chunk.Starts.reserve((until - from) / 4 + 1);
+    chunk.Begin = from;
+    mPos = from;
+    mCollected.clear();
+    mSignificant = 0;
+    try {
+        while (mPos < until) {
+            chunk.Starts.push_back(std::uint32_t(mPos));
+            chunk.Tokens.push(next());
         }
-        case '+': {
-            switch(cc) {
-                case '+': return tok({Token::OP_PLUS_PLUS},2);
-                case '=': return tok({Token::OP_PLUS_EQ}, 2);
-                default: return tok({Token::PLUS});
-            }
-            break;
+        // unless trailing trivia was returned as tokens, T_EOF may already be in
+        auto& tokens = chunk.Tokens;
+        if (until >= mCode.size() && (tokens.size() == 0 || tokens.kind(tokens.size() - 1) != Token::T_EOF)) {
+            chunk.Starts.push_back(std::uint32_t(mPos));
+            chunk.Tokens.push(next());
         }
-        case '-': {
-            switch(cc) {
-                case '>': return tok({Token::RARROW},2);
-                case '-': return tok({Token::OP_MINUS_MINUS},2);
-                case '=': return tok({Token::OP_MINUS_EQ}, 2);
-                default: return tok({Token::MINUS});
-            }
-            break;
+    }
+    catch (...) {
+        chunk.Error = std::current_exception();
+    }
+    chunk.Exit = mPos;
+    chunk.Tokens.Leading = std::move(mCollected);
+    mCollected.clear();
+}
+
+TokenBuffer Tokenizer::tokenizeAll(unsigned threads)
+{
+    constexpr std::size_t MinChunk = 256 * 1024;
+    auto size = mCode.size() - mPos;
+    threads = unsigned(std::min<std::size_t>(threads, size / MinChunk));
+    if (threads <= 1) {
+        return tokenizeAll();
+    }
+    if (mCode.size() > UINT32_MAX) {
+        throw Exception("source '" + std::string{mSource} + "' is too large to tokenize (> 4GB)");
+    }
+
+    // guess that every chunk begins with the line following its share of the input
+    std::vector<std::size_t> bounds{mPos};
+    for (unsigned i = 1; i < threads; i++) {
+        auto guess = mPos + size * i / threads;
+        const auto *nl = scan::find(mCode.data() + guess, mCode.data() + mCode.size(), '\n');
+        bounds.push_back(std::min(std::size_t(nl - mCode.data()) + 1, mCode.size()));
+    }
+    bounds.push_back(mCode.size());
+    // guesses within the same line, or the last one, end up at the same bound,
+    // an empty chunk at the end of the code would add a T_EOF of its own
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+    threads = unsigned(bounds.size() - 1);
+
+    std::vector<Chunk> chunks(threads);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back([this, &chunks, &bounds, i] {
+            Tokenizer tokenizer{mCode, mSource};
+            tokenizer.mPadded = mPadded;
+            tokenizer.recover(mRecover);
+            tokenizer.trivia(mTriviaMode);
+            tokenizer.tokenizeRange(chunks[i], bounds[i], bounds[i + 1]);
+        });
+    }
+    for (auto& worker: workers) worker.join();
+
+    TokenBuffer buffer{mCode};
+    buffer.reserve(size / 4 + 1);
+    std::size_t exit{mPos};
+    for (unsigned i = 0; i < threads; i++) {
+        auto* chunk = &chunks[i];
+        auto& starts = chunk->Starts;
+        // the speculation holds from the first token starting where the previous chunk stopped
+        auto it = std::lower_bound(starts.begin(), starts.end(), exit);
+        if (it == starts.end() || *it != exit) {
+            Chunk relexed;
+            Tokenizer tokenizer{mCode, mSource};
+            tokenizer.mPadded = mPadded;
+            tokenizer.recover(mRecover);
+            tokenizer.trivia(mTriviaMode);
+            tokenizer.tokenizeRange(relexed, exit, std::max(exit, bounds[i + 1]));
+            chunks[i] = std::move(relexed);
+            it = starts.begin();
         }
-        case '*': {
-            switch(cc) {
-                case '=': return tok({Token::OP_MULT_EQ}, 2);
-                default: return tok({Token::STAR});
-            }
-            break;
+        if (chunk->Error) {
+            std::rethrow_exception(chunk->Error);
         }
-        case '/': {
-            switch(cc) {
-                case '=': return tok({Token::OP_DIV_EQ}, 2);
-                case '/': { eat(2); return parseSingleLineComment(); }
-                case '*': { eat(2); return parseMultiLineComment(); }
-                default: return tok({Token::SLASH});
-            }
-            break;
+
+        auto from = std::size_t(it - starts.begin());
+        auto& tokens = chunk->Tokens;
+        // trivia of the discarded speculative tokens is dropped with them
+        auto base = buffer.size();
+        for (auto& trivia: tokens.Leading) {
+            if (trivia.Next < from) continue;
+            trivia.Next = std::uint32_t(trivia.Next - from + base);
+            buffer.Leading.push_back(trivia);
         }
-        case '%': {
-            switch(cc) {
-                case '=': return tok({Token::OP_MOD_EQ}, 2);
-                default: return tok({Token::PERCENT});
+        buffer.Kinds.insert(buffer.Kinds.end(), tokens.Kinds.begin() + from, tokens.Kinds.end());
+        buffer.Offsets.insert(buffer.Offsets.end(), tokens.Offsets.begin() + from, tokens.Offsets.end());
+        buffer.Lengths.insert(buffer.Lengths.end(), tokens.Lengths.begin() + from, tokens.Lengths.end());
+        // workers never touch the interner, names are interned in order while merging
+        for (auto j = from; j < tokens.size(); j++) {
+            auto id = Interner::None;
+            if (mNames != nullptr && tokens.kind(j) == Token::IDENTIFIER) {
+                id = mNames->intern(tokens.value(j));
             }
-            break;
+            buffer.Ids.push_back(id);
         }
-        case '^': {
-            switch(cc) {
-                case '=': return tok({Token::OP_XOR_EQ}, 2);
-                default: return tok({Token::CARET});
-            }
-            break;
+        exit = chunk->Exit;
+        // free each chunk as soon as it has been merged
+        *chunk = {};
+    }
+    mPos = exit;
+    return buffer;
+}
+
+std::pair<std::size_t, std::size_t> Tokenizer::relex(TokenBuffer& tokens, std::string_view code, const Edit& edit)
+{
+    if (code.size() > UINT32_MAX) {
+        throw Exception("source '" + std::string{mSource} + "' is too large to tokenize (> 4GB)");
+    }
+
+    // tokens starting this far before the edit could not have looked into it
+    std::size_t first{0}, from{0};
+    auto size = tokens.size();
+    {
+        std::size_t lo{0}, hi{size};
+        while (lo < hi) {
+            auto mid = (lo + hi) / 2;
+            if (tokens.start(mid) + Lookahead <= edit.Offset) lo = mid + 1;
+            else hi = mid;
         }
-        case '|': {
-            switch(cc) {
-                case '|': return tok({Token::OP_LOR},2);
-                case '=': return tok({Token::OP_OR_EQ}, 2);
-                default: return tok({Token::BAR});
+        if (lo > 0) {
+            first = lo - 1;
+            from = tokens.start(first);
+        }
+    }
+
+    mCode = code;
+    mPadded = false;
+    mPos = from;
+    mLines = {};
+    mCollected.clear();
+    mSignificant = 0;
+
+    // lex until a token starts past the edit exactly where an old one did
+    auto delta = std::ptrdiff_t(edit.Inserted.size()) - std::ptrdiff_t(edit.Removed);
+    auto end = edit.Offset + edit.Inserted.size();
+    auto last = first;
+    TokenBuffer fresh{code};
+    do {
+        auto tok = next();
+        auto begin = std::size_t(tok.Value.data() - code.data()) - opening(tok.kind);
+        if (begin >= end) {
+            auto old = std::size_t(std::ptrdiff_t(begin) - delta);
+            while (last < size && tokens.start(last) < old) last++;
+            if (last < size && tokens.start(last) == old) {
+                break;
             }
+        }
+        fresh.push(tok);
+        if (tok.kind == Token::T_EOF) {
+            last = size;
             break;
         }
-        case '&': {
-            switch(cc) {
-                case '&': return tok({Token::OP_LAND},2);
-                case '=': return tok({Token::OP_AND_EQ}, 2);
-                default: return tok({Token::AMPERSAND});
-            }
+    } while (true);
+
+    auto n = fresh.size();
+    tokens.shift(last, delta);
+    splice(tokens.Kinds, first, last, fresh.Kinds);
+    splice(tokens.Offsets, first, last, fresh.Offsets);
+    splice(tokens.Lengths, first, last, fresh.Lengths);
+    splice(tokens.Ids, first, last, fresh.Ids);
+    tokens.mShiftFrom = first + n;
+    tokens.mCode = code;
+
+    if (mTriviaMode == TRIVIA_COLLECT) {
+        // the trivia from the restart up to the resynchronized token was collected again
+        auto& leading = tokens.Leading;
+        auto lo = std::partition_point(leading.begin(), leading.end(),
+                                       [&](const Trivia& t) { return t.Offset < from; });
+        auto hi = std::partition_point(lo, leading.end(),
+                                       [&](const Trivia& t) { return t.Next <= last; });
+        for (auto it = hi; it != leading.end(); it++) {
+            it->Next = std::uint32_t(it->Next + n + first - last);
+            it->Offset = std::uint32_t(it->Offset + delta);
+        }
+        for (auto& trivia: mCollected) trivia.Next = std::uint32_t(trivia.Next + first);
+        auto at = lo - leading.begin();
+        leading.erase(lo, hi);
+        leading.insert(leading.begin() + at, mCollected.begin(), mCollected.end());
+        mCollected.clear();
+    }
+    return {first, first + n};
+}
+
+/*
+ * The lexer looks at every byte of the other tokens, non-ASCII ones only ever
+ * make it into a string, a comment or a character literal unchecked.
+ */
+Token Tokenizer::text(std::size_t start, Token&& tok)
+{
+    if (mPos <= mValid) {
+        return std::move(tok);
+    }
+    return validate(start, std::move(tok));
+}
+
+Token Tokenizer::validate(std::size_t start, Token&& tok)
+{
+    // bytes before the token belong to code that was not lexed (relex, parallel chunks)
+    mValid = std::max(mValid, start);
+    const auto *data = mCode.data();
+    auto invalid = mPos;
+    while (mValid < mPos) {
+        auto until = std::min(mCode.size(), std::max(mPos, mValid + ValidationBlock));
+        auto p = std::size_t(scan::utf8(data + mValid, data + until) - data);
+        if (p == until) {
+            mValid = until;
+            continue;
+        }
+        // the sequence might only be cut short by the block
+        auto n = utf8::sequence(data + p, data + mCode.size());
+        if (n == 0 && p >= mPos) {
+            // reported with the token it belongs to
+            mValid = p;
             break;
         }
-        case '.': {
-            if (cc ==  '.') {
-                if (ccc == '.') {
-                    return tok({Token::OP_ELIPSE}, 3);
-                }
-                return tok({Token::OP_SEQUENCE}, 2);
-            }
-            return tok({Token::DOT});
+        if (n == 0) {
+            invalid = std::min(invalid, p);
+            n = 1;
         }
-        case ':': {
-            if (cc ==  ':') {
-                return tok({Token::OP_SCOPE}, 2);
-            }
-            return tok({Token::COLON});
+        mValid = p + n;
+    }
+
+    if (invalid == mPos || tok.kind == Token::ERROR) {
+        return std::move(tok);
+    }
+    if (!mRecover) {
+        // report where the sequence starts rather than where the token does
+        mPos = invalid;
+    }
+    return fail(Token::E_INVALID_UTF8, start, '\0',
+        "invalid UTF-8 sequence at byte ", charString(mCode[invalid]));
+}
+
+Token Tokenizer::next()
+{
+    if (mTriviaMode == TRIVIA_TOKENS) {
+        return mPadded? token<true>() : token<false>();
+    }
+    do {
+        auto start = mPos;
+        auto tok = mPadded? token<true>() : token<false>();
+        if (tok.kind != Token::WHITESPACE && tok.kind != Token::COMMENT) {
+            mSignificant++;
+            return tok;
         }
-        case '<': {
-            switch(cc) {
-                case '=': return tok({Token::OP_LTE},2);
-                case '-': return tok({Token::LARROW}, 2);
-                case '<': {
-                    if (ccc == '=') {
-                        return tok({Token::OP_LSHIFT_EQ}, 3);
-                    }
-                    return tok({Token::OP_LSHIFT}, 2);
-                }
-                default: return tok({Token::LESS_THAN});
+        if (mTriviaMode == TRIVIA_COLLECT) {
+            mCollected.push_back({std::uint32_t(mSignificant),
+                                  std::uint32_t(start),
+                                  std::uint32_t(mPos - start),
+                                  tok.kind});
+        }
+    } while (true);
+}
+
+template <bool Padded>
+Token Tokenizer::token()
+{
+    if constexpr (!Padded) {
+        if (mPos >= mCode.size()) {
+            return {Token::T_EOF, mCode.substr(mCode.size())};
+        }
+    }
+
+    auto c = mCode.data()[mPos];
+    switch (lex::info(c).Lead) {
+        case lex::L_PUNCT: {
+            // longest match through the DFA generated from lex::Punctuators
+            const auto& table = lex::Table;
+            std::uint8_t state{0}, next;
+            auto pos = mPos;
+            // the sentinel has no transitions
+            while ((Padded || pos < mCode.size()) &&
+                   (next = table.Next[state][lex::info(mCode.data()[pos]).Class]) != 0) {
+                state = next;
+                pos++;
+            }
+
+            auto kind = table.Accept[state];
+            auto len = unsigned(pos - mPos);
+            if (kind == Token::COMMENT) {
+                auto multiline = mCode[mPos + 1] == '*';
+                eat<Padded>(len);
+                return multiline? parseMultiLineComment<Padded>() : parseSingleLineComment();
+            }
+            if (kind != Token::T_EOF) {
+                auto start = mPos;
+                mPos = pos;
+                return {kind, mCode.substr(start, len)};
             }
             break;
         }
-        case '>': {
-            switch(cc) {
-                case '=': return tok({Token::OP_GTE},2);
-                case '>': {
-                    if (ccc == '=') {
-                        return tok({Token::OP_RSHIFT_EQ}, 3);
-                    }
-                    return tok({Token::OP_RSHIFT}, 2);
-                }
-                default: return tok({Token::GREATER_THAN});
+        case lex::L_SPACE: {
+            // single separators are by far the most common, keep them off the kernels
+            auto start = mPos;
+            if ((Padded || mPos + 1 < mCode.size()) && !lex::is(mCode.data()[mPos + 1], lex::F_SPACE)) {
+                eat<Padded>();
             }
-            break;
+            else {
+                eatWhiteSpace();
+            }
+            return {Token::WHITESPACE, mCode.substr(start, mPos - start)};
         }
-        case '"': { eat(); return parseString(); }
-        case '\'': { eat(); return parseCharacter(); }
-        case '0': {
+        case lex::L_IDENT:
+            return parseIdentifier();
+        case lex::L_DIGIT:
+            return parseDecimalNumber<Padded>();
+        case lex::L_ZERO: {
+            auto cc = peekTwo<Padded>().second;
             switch(cc) {
                 case 'b':
-                case 'B': { return parseBinaryNumber(); }
+                case 'B': { return parseBinaryNumber<Padded>(); }
                 case 'x':
-                case 'X': { return parseHexNumber(); }
+                case 'X': { return parseHexNumber<Padded>(); }
                 default: break;
             }
 
-            if (isdigit(cc)) {
-                return parseOctalNumber();
+            if (lex::is(cc, lex::F_DIGIT)) {
+                return parseOctalNumber<Padded>();
             }
-            else {
-                // a decimal digit which is 0
-                return tok({Token::DEC_LITERAL, mCode.substr(mPos, 1)});
-            }
-        }
-        default: {
-            if (isspace(c)) {
-                eat();
-                eatWhiteSpace();
-                return {Token::WHITESPACE};
-            }
-            else if (isdigit(c)) {
-                return parseDecimalNumber();
-            }
-            else if (isalpha(c) || c == '_'){
-                return parseIdentifier();
-            }
-            else if (c == '$' and cc == '{') {
-                return tok({Token::STREXPR}, 2);
-            }
-            else {
-                eat();
-                throw SyntaxError(
-                    mSource, mLine, mCol,
-                    "Unexpected '", charString(c), "'");
+            if (cc == '.' || cc == 'e' || cc == 'E') {
+                // 0.5, 0e1 or 0 followed by a '.' or '..' operator
+                return parseDecimalNumber<Padded>();
             }
+            // a decimal digit which is 0
+            return tok<Padded>({Token::DEC_LITERAL, mCode.substr(mPos, 1)});
         }
+        case lex::L_STRING: { eat<Padded>(); return parseString<Padded>(); }
+        case lex::L_CHAR: { eat<Padded>(); return parseCharacter<Padded>(); }
+        case lex::L_UTF8:
+            return parseUnicode();
+        default:
+            break;
     }
 
-    return {Token::T_EOF};
+    if (Padded && mPos >= mCode.size()) {
+        // the sentinel at the end of padded code
+        return {Token::T_EOF, mCode.substr(mCode.size())};
+    }
+    eat<Padded>();
+    return fail(Token::E_UNEXPECTED_CHAR, mPos - 1, '\0',
+        "Unexpected '", charString(c), "'");
+}
+
+std::string_view Token::message(Error error)
+{
+    switch (error) {
+        case E_NONE: return "no error";
+        case E_UNEXPECTED_CHAR: return "unexpected character";
+        case E_CHAR_ESCAPE: return "unsupported character escape";
+        case E_UNTERMINATED_CHAR: return "unterminated character literal";
+        case E_STRING_ESCAPE: return "unsupported escape in string";
+        case E_UNTERMINATED_STRING: return "unterminated string, EOF before closing '\"'";
+        case E_UNTERMINATED_COMMENT: return "unterminated multiline comment, EOF before */";
+        case E_HEX_FLOAT_EXPONENT: return "hexadecimal floating point literal requires a binary exponent ('p')";
+        case E_EXPONENT_DIGITS: return "exponent of floating point literal has no digits";
+        case E_INVALID_UTF8: return "invalid UTF-8 sequence";
+        default: return "unknown error";
+    }
 }
 
 void Token::toString(std::ostream& os, bool includeValue) const
@@ -587,6 +1107,7 @@ void Token::toString(std::ostream& os, bool includeValue) const
         case Token::BOOL_TYPE: { os << "BOOL_TYPE"; break; }
         case Token::CODE_TYPE: { os << "CODE_TYPE"; break; }
         case Token::FLOAT_TYPE: { os << "FLOAT_TYP"; break; }
+        case Token::ERROR: { os << "ERROR"; break; }
         default: { os << "Tok_" << int(kind); break; }
     }
 
@@ -602,4 +1123,353 @@ void Token::toString(std::ostream& os, bool includeValue) const
 
 using cyntactic::Token;
 using cyntactic::Tokenizer;
-#endif
\ No newline at end of file
+TEST_CASE("Tokenizer lexes every punctuator in the token spec", "[tokenizer]")
+{
+    for (const auto& p: cyntactic::lex::Punctuators) {
+        if (p.Kind == Token::COMMENT) continue;
+        Tokenizer tokenizer{p.Text};
+        CHECK(tokenizer.next().kind == p.Kind);
+        CHECK(tokenizer.next().kind == Token::T_EOF);
+    }
+
+    Tokenizer tokenizer{"a<<=b...c// x\n/* y */$"};
+    for (auto kind: {Token::IDENTIFIER, Token::OP_LSHIFT_EQ, Token::IDENTIFIER,
+                     Token::OP_ELIPSE, Token::IDENTIFIER, Token::COMMENT, Token::COMMENT}) {
+        CHECK(tokenizer.next().kind == kind);
+    }
+    CHECK_THROWS_AS(tokenizer.next(), cyntactic::SyntaxError);
+}
+TEST_CASE("tokenizeAll matches the token stream of next()", "[tokenizer]")
+{
+    std::string_view code{"import a.{b, c};\n'\\n' + \"str\" * 0x1F; // done"};
+    Tokenizer tokenizer{code};
+    auto buffer = Tokenizer{code}.tokenizeAll();
+    for (std::size_t i = 0; i < buffer.size(); i++) {
+        auto tok = tokenizer.next();
+        CHECK(buffer.kind(i) == tok.kind);
+        CHECK(buffer.value(i) == tok.Value);
+    }
+    CHECK(buffer.kind(buffer.size() - 1) == Token::T_EOF);
+    CHECK(buffer.value(12) == "\\n");
+    CHECK(buffer.value(16) == "str");
+}
+TEST_CASE("String escapes are decoded through the lexer tables", "[tokenizer]")
+{
+    auto decode = [](std::string_view raw) {
+        std::string out(raw.size(), '\0');
+        out.resize(cyntactic::lex::unescape(raw, out.data()));
+        return out;
+    };
+    CHECK(decode("") == "");
+    CHECK(decode("no escapes") == "no escapes");
+    CHECK(decode("\\n") == "\n");
+    CHECK(decode("a\\tb\\\\c\\$\\\"d\\0") == std::string{"a\tb\\c$\"d\0", 9});
+    CHECK(decode("\\b\\f\\r\\v\\?\\'") == "\b\f\r\v?'");
+}
+
+TEST_CASE("Floating point literals", "[tokenizer]")
+{
+    auto buffer = Tokenizer{"1.5e-3 0.25 0x1.8p3 0X10P+4 7E2 1..2 0.x"}.tokenizeAll();
+    std::vector<Token::Kind> kinds{
+        Token::FLOAT_LITERAL, Token::FLOAT_LITERAL, Token::FLOAT_LITERAL, Token::FLOAT_LITERAL,
+        Token::FLOAT_LITERAL, Token::DEC_LITERAL, Token::OP_SEQUENCE, Token::DEC_LITERAL,
+        Token::DEC_LITERAL, Token::DOT, Token::IDENTIFIER, Token::T_EOF};
+    std::vector<Token::Kind> lexed;
+    for (std::size_t i = 0; i < buffer.size(); i++) {
+        if (buffer.kind(i) != Token::WHITESPACE) lexed.push_back(buffer.kind(i));
+    }
+    CHECK(lexed == kinds);
+    CHECK(buffer.value(4) == "0x1.8p3");
+
+    CHECK_THROWS_AS(Tokenizer{"1e+"}.tokenizeAll(), cyntactic::SyntaxError);
+    CHECK_THROWS_AS(Tokenizer{"0x1.8"}.tokenizeAll(), cyntactic::SyntaxError);
+}
+TEST_CASE("Recovering tokenizer reports every lexical error in one pass", "[tokenizer]")
+{
+    std::string_view code{"x = 'ab';\ny = \"a\\qb\";\nz = \"a\\q \\\" b\" + 'a\\'b';\n1e + 0x1.8;\n#\n/* open"};
+    CHECK_THROWS_AS(Tokenizer{code}.tokenizeAll(), cyntactic::SyntaxError);
+
+    Tokenizer tokenizer{code};
+    tokenizer.recover(true);
+    auto buffer = tokenizer.tokenizeAll();
+    std::vector<Token::Error> errors;
+    std::vector<std::string_view> values;
+    for (std::size_t i = 0; i < buffer.size(); i++) {
+        auto tok = buffer[i];
+        if (tok.kind == Token::ERROR) {
+            errors.push_back(tok.error());
+            values.push_back(tok.Value);
+            // resynchronized right after the broken token
+            CHECK(buffer.kind(i + 1) != Token::ERROR);
+        }
+    }
+    CHECK(errors == std::vector<Token::Error>{
+        Token::E_UNTERMINATED_CHAR, Token::E_STRING_ESCAPE,
+        Token::E_STRING_ESCAPE, Token::E_UNTERMINATED_CHAR, Token::E_EXPONENT_DIGITS,
+        Token::E_HEX_FLOAT_EXPONENT, Token::E_UNEXPECTED_CHAR, Token::E_UNTERMINATED_COMMENT});
+    // escaped quotes do not end a broken literal
+    CHECK(values == std::vector<std::string_view>{"'ab'", "\"a\\qb\"", "\"a\\q \\\" b\"", "'a\\'b'", "1e", "0x1.8", "#", "/* open"});
+    CHECK(buffer.kind(buffer.size() - 1) == Token::T_EOF);
+}
+TEST_CASE("Token extents include the quotes and comment markers around values", "[tokenizer]")
+{
+    // the first piece of a string expression ends at the ${
+    std::string_view code{"\"s\" 'c' /* b */ // l\n\"a${x"};
+    auto buffer = Tokenizer{code}.tokenizeAll();
+    std::vector<std::string_view> extents;
+    for (std::size_t i = 0; i + 1 < buffer.size(); i++) {
+        if (buffer.kind(i) != Token::WHITESPACE) {
+            extents.push_back(code.substr(buffer.start(i), buffer.end(i) - buffer.start(i)));
+        }
+    }
+    CHECK(extents == std::vector<std::string_view>{"\"s\"", "'c'", "/* b */", "// l", "\"a", "${", "x"});
+}
+
+TEST_CASE("Collected trivia is attached to the next significant token", "[tokenizer]")
+{
+    std::string_view code{"  a /* one */ + // two\n b\n"};
+    Tokenizer tokenizer{code};
+    tokenizer.trivia(Tokenizer::TRIVIA_COLLECT);
+    auto buffer = tokenizer.tokenizeAll();
+    REQUIRE(buffer.size() == 4);
+    CHECK(buffer.kind(1) == Token::PLUS);
+
+    auto text = [&](std::size_t i) {
+        std::string all;
+        for (auto [it, end] = buffer.leading(i); it != end; it++) {
+            all += code.substr(it->Offset, it->Length);
+        }
+        return all;
+    };
+    CHECK(text(0) == "  ");
+    CHECK(text(1) == " /* one */ ");
+    CHECK(text(2) == " // two\n ");
+    CHECK(text(3) == "\n");
+    CHECK(buffer.leading(1).first->kind == Token::WHITESPACE);
+    CHECK((buffer.leading(1).first + 1)->kind == Token::COMMENT);
+
+    tokenizer.reset(code);
+    tokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+    buffer = tokenizer.tokenizeAll();
+    CHECK(buffer.size() == 4);
+    CHECK(buffer.Leading.empty());
+}
+
+TEST_CASE("Relexing an edit matches tokenizing the edited code", "[tokenizer]")
+{
+    std::string code{
+        "import mod.{a, b}; // first\n"
+        "x <<= 0x1F + 1.5e3 - 'c' * \"str\" /* block */ ;\n"
+        "y = 1..2 + z.w - 0x1.8p3;\n"};
+    const std::string_view Alphabet{" \n\"'/*.1ex+-;"};
+    for (auto mode: {Tokenizer::TRIVIA_TOKENS, Tokenizer::TRIVIA_COLLECT, Tokenizer::TRIVIA_SKIP}) {
+        auto text = code;
+        Tokenizer tokenizer{text};
+        tokenizer.recover(true);
+        tokenizer.trivia(mode);
+        auto tokens = tokenizer.tokenizeAll();
+        std::uint32_t seed{mode + 1u};
+        auto random = [&](std::size_t n) { seed = seed * 1664525u + 1013904223u; return (seed >> 8) % n; };
+        for (unsigned i = 0; i < 300; i++) {
+            cyntactic::Edit edit{random(text.size() + 1), 0, {}};
+            edit.Removed = std::min<std::size_t>(random(4), text.size() - edit.Offset);
+            auto inserted = Alphabet.substr(random(Alphabet.size()), random(3));
+            if (text.size() > 200) inserted = {};
+            edit.Inserted = inserted;
+            text.replace(edit.Offset, edit.Removed, inserted);
+            tokenizer.relex(tokens, text, edit);
+
+            Tokenizer full{text};
+            full.recover(true);
+            full.trivia(mode);
+            auto expected = full.tokenizeAll();
+            REQUIRE(tokens.size() == expected.size());
+            for (std::size_t j = 0; j < tokens.size(); j++) {
+                REQUIRE(tokens.kind(j) == expected.kind(j));
+                REQUIRE(tokens.offset(j) == expected.Offsets[j]);
+                REQUIRE(tokens.value(j) == expected.value(j));
+            }
+            REQUIRE(tokens.Leading.size() == expected.Leading.size());
+            for (std::size_t j = 0; j < tokens.Leading.size(); j++) {
+                REQUIRE(tokens.Leading[j].Next == expected.Leading[j].Next);
+                REQUIRE(tokens.Leading[j].Offset == expected.Leading[j].Offset);
+            }
+            if (i % 50 == 0) {
+                tokens.settle();
+                REQUIRE(tokens.Offsets == expected.Offsets);
+            }
+        }
+    }
+}
+
+TEST_CASE("Padded and bounds checked tokenization agree at the end of the code", "[tokenizer]")
+{
+    std::vector<std::string> inputs{"x ", "x", "// c", "/* c", "'", "'a", "'\\", "\"ab", "\"\\", "1e", "1e+",
+                                    "0x", "0x1.", "0", "1.", "0b", "$", "@", "\xC3", "x\xE2\x82", "\xC3\xA9",
+                                    "\"\xF0\x9F\x98"};
+    for (const auto& p: cyntactic::lex::Punctuators) inputs.emplace_back(p.Text);
+    for (const auto& input: inputs) {
+        auto source = cyntactic::SourceBuffer::copy(input, "<padded>");
+        Tokenizer padded{*source}, checked{input};
+        padded.recover(true);
+        checked.recover(true);
+        auto a = padded.tokenizeAll(), b = checked.tokenizeAll();
+        INFO(input);
+        REQUIRE(a.size() == b.size());
+        CHECK(a.Kinds == b.Kinds);
+        CHECK(a.Offsets == b.Offsets);
+        CHECK(a.Lengths == b.Lengths);
+        CHECK(a.Ids == b.Ids);
+    }
+}
+
+TEST_CASE("UTF-8 identifiers, strings and comments", "[tokenizer]")
+{
+    std::string code{"caf\xC3\xA9 = \xCF\x80 * x\xCC\x81_1 + \"str\xC3\xB6m\" // \xE2\x82\xAC\n"
+                     "/* \xF0\x9F\x98\x80 */ \xE5\x90\x8D\xE5\x89\x8D"};
+    Tokenizer tokenizer{code};
+    tokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+    auto buffer = tokenizer.tokenizeAll();
+    std::vector<std::string_view> values;
+    for (std::size_t i = 0; i + 1 < buffer.size(); i++) values.push_back(buffer.value(i));
+    CHECK(values == std::vector<std::string_view>{"caf\xC3\xA9", "=", "\xCF\x80", "*", "x\xCC\x81_1", "+",
+                                                  "str\xC3\xB6m", "\xE5\x90\x8D\xE5\x89\x8D"});
+    CHECK(buffer.kind(0) == Token::IDENTIFIER);
+    CHECK(buffer.kind(4) == Token::IDENTIFIER);
+
+    // a combining mark cannot start an identifier and the euro sign is not part of one
+    CHECK_THROWS_AS(Tokenizer{"\xCC\x81x"}.tokenizeAll(), cyntactic::SyntaxError);
+    CHECK_THROWS_AS(Tokenizer{"a\xE2\x82\xAC"}.tokenizeAll(), cyntactic::SyntaxError);
+}
+
+TEST_CASE("Ill formed UTF-8 is reported with the token containing it", "[tokenizer]")
+{
+    // the broken string lies past the first validation block
+    std::string code(Tokenizer::ValidationBlock + 10, ' ');
+    code += "\"ab\xC3(\" x \xFF y /* \xED\xA0\x80 */ z";
+    try {
+        Tokenizer{code}.tokenizeAll();
+        FAIL("ill formed UTF-8 was accepted");
+    }
+    catch (cyntactic::SyntaxError& e) {
+        // reported at the offending byte, not at the start of the string
+        CHECK(std::string_view{e.what()}.find(":1:" + std::to_string(Tokenizer::ValidationBlock + 14) + ":") !=
+              std::string_view::npos);
+    }
+
+    for (bool padded: {false, true}) {
+        auto source = cyntactic::SourceBuffer::copy(code, "<utf8>");
+        Tokenizer tokenizer = padded? Tokenizer{*source} : Tokenizer{code};
+        tokenizer.recover(true);
+        tokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+        auto buffer = tokenizer.tokenizeAll();
+        std::vector<std::string_view> values;
+        std::vector<Token::Kind> kinds;
+        for (std::size_t i = 0; i + 1 < buffer.size(); i++) {
+            values.push_back(buffer.value(i));
+            kinds.push_back(buffer.kind(i));
+        }
+        // even skipped trivia is replaced when it is ill formed
+        CHECK(values == std::vector<std::string_view>{"\"ab\xC3(\"", "x", "\xFF", "y",
+                                                      "/* \xED\xA0\x80 */", "z"});
+        CHECK(kinds == std::vector<Token::Kind>{Token::ERROR, Token::IDENTIFIER, Token::ERROR,
+                                                Token::IDENTIFIER, Token::ERROR, Token::IDENTIFIER});
+        CHECK(buffer[0].error() == Token::E_INVALID_UTF8);
+        CHECK(buffer[2].error() == Token::E_INVALID_UTF8);
+    }
+}
+
+TEST_CASE("Parallel tokenization is identical to serial tokenization", "[tokenizer]")
+{
+    // a large comment in the middle makes the line start guesses land inside a token
+    std::string code;
+    auto fill = [&](std::size_t size, std::string_view unit) {
+        while (code.size() < size) code += unit;
+    };
+    fill(3 << 19, "import mod.{a, b};\nx <<= 0x1F + 'c' - \"str\";   // trailing\n");
+    code += "/*";
+    fill(5 << 19, "a comment line with ' quotes \" and /* nesting\n");
+    code += "*/";
+    fill(4 << 20, "import mod.{a, b};\nx <<= 0x1F + 'c' - \"str\";   // trailing\n");
+
+    cyntactic::Interner names;
+    Tokenizer tokenizer{code};
+    tokenizer.intern(&names);
+    auto serial = tokenizer.tokenizeAll();
+    CHECK(names.size() == 4);
+    CHECK(serial.Ids[2] == names.find("mod"));
+    for (unsigned threads: {2, 3, 8}) {
+        cyntactic::Interner others;
+        tokenizer = Tokenizer{code};
+        tokenizer.intern(&others);
+        auto parallel = tokenizer.tokenizeAll(threads);
+        REQUIRE(parallel.size() == serial.size());
+        CHECK(parallel.Kinds == serial.Kinds);
+        CHECK(parallel.Offsets == serial.Offsets);
+        CHECK(parallel.Lengths == serial.Lengths);
+        CHECK(parallel.Ids == serial.Ids);
+    }
+
+    auto leading = [](const cyntactic::TokenBuffer& buffer) {
+        std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>> all;
+        for (const auto& trivia: buffer.Leading) all.emplace_back(trivia.Next, trivia.Offset, trivia.Length);
+        return all;
+    };
+    tokenizer = Tokenizer{code};
+    tokenizer.trivia(Tokenizer::TRIVIA_COLLECT);
+    serial = tokenizer.tokenizeAll();
+    for (unsigned threads: {2, 3, 8}) {
+        tokenizer = Tokenizer{code};
+        tokenizer.trivia(Tokenizer::TRIVIA_COLLECT);
+        auto parallel = tokenizer.tokenizeAll(threads);
+        REQUIRE(parallel.size() == serial.size());
+        CHECK(parallel.Offsets == serial.Offsets);
+        CHECK(leading(parallel) == leading(serial));
+    }
+
+    code += "$";
+    CHECK_THROWS_AS(Tokenizer{code}.tokenizeAll(4), cyntactic::SyntaxError);
+
+    // the guesses that land on a last line longer than a share all end at the end of the code
+    code = "a;\n";
+    fill(1 << 20, "import mod.{a, b};\n");
+    fill(3 << 20, "x + ");
+    code += "1;";
+    serial = Tokenizer{code}.tokenizeAll();
+    for (unsigned threads: {2, 4, 8}) {
+        auto parallel = Tokenizer{code}.tokenizeAll(threads);
+        REQUIRE(parallel.size() == serial.size());
+        CHECK(parallel.Kinds == serial.Kinds);
+        CHECK(parallel.Offsets == serial.Offsets);
+    }
+}
+
+TEST_CASE("Skipping a body only counts braces outside literals and comments", "[tokenizer]")
+{
+    using cyntactic::Token;
+    using cyntactic::Tokenizer;
+    auto skip = [](std::string_view code) -> std::size_t {
+        Tokenizer tokenizer{code};
+        tokenizer.trivia(Tokenizer::TRIVIA_SKIP);
+        auto tok = tokenizer.next();
+        REQUIRE(tok.kind == Token::LBRACE);
+        if (!tokenizer.skipBody()) {
+            CHECK(tokenizer.offset() == 1);
+            return 0;
+        }
+        // lexing resumes right after the body
+        CHECK(tokenizer.next().kind == Token::SEMICOLON);
+        return tokenizer.offset() - 1;
+    };
+    CHECK(skip("{};") == 2);
+    CHECK(skip("{ a + { b; { c; } } };") == 21);
+    CHECK(skip("{ \"}\" + '}' + '\\'' + \"\\\"}\"; };") == 29);
+    CHECK(skip("{ // }\n /* } */ 1; /**/ /*/ } */ };") == 34);
+    CHECK(skip("{ a / b; } ;") == 11);
+
+    CHECK(skip("{ { }") == 0);
+    CHECK(skip("{ \"} ;") == 0);
+    CHECK(skip("{ /* } ;") == 0);
+    CHECK(skip("{ // } ;") == 0);
+}
+#endif